@@ -0,0 +1,238 @@
+#include "geometry.hpp"
+//
+#include <numeric>
+//
+#include <exaggerated-shading-demo/mapped_file.hpp>
+#include <exaggerated-shading-demo/obj_import.hpp>
+#include <exaggerated-shading-demo/ply_import.hpp>
+#include <exaggerated-shading-demo/reordering.hpp>
+//
+#include "mesh_generators.hpp"
+#include "timing.hpp"
+
+namespace demo {
+
+namespace {
+
+constexpr size_t sizes[] = {10'000, 100'000, 1'000'000, 10'000'000,
+                            50'000'000};
+
+// Parameters of the processing in the viewer
+constexpr uint32 scales = 10;
+constexpr auto encoding = normal_encoding::octahedral;
+
+/// Write the faces of the scene as binary STL file.
+///
+void write_binary_stl(const filesystem::path& path, const scene& s) {
+  fstream file{path, ios::out | ios::binary};
+  if (!file.is_open())
+    throw runtime_error(
+        format("Failed to create STL file at path '{}'.", path.string()));
+  const stl_surface::header header{};
+  file.write((const char*)header.data(), header.size());
+  const auto size = stl_surface::size_type(s.faces.size());
+  file.write((const char*)&size, sizeof(size));
+  const stl_surface::attribute_byte_count_type attribute{};
+  for (const auto& [i, j, k] : s.faces) {
+    const auto& a = s.vertices[i].position;
+    const auto& b = s.vertices[j].position;
+    const auto& c = s.vertices[k].position;
+    const stl_surface::triangle t{.normal = normalize(cross(b - a, c - a)),
+                                  .vertex = {a, b, c}};
+    file.write((const char*)&t, sizeof(t));
+    file.write((const char*)&attribute, sizeof(attribute));
+  }
+  if (!file)
+    throw runtime_error(
+        format("Failed to write STL file at path '{}'.", path.string()));
+}
+
+/// Write the vertex positions and faces of the scene as OBJ file.
+///
+void write_obj(const filesystem::path& path, const scene& s) {
+  ofstream file{path};
+  if (!file.is_open())
+    throw runtime_error(
+        format("Failed to create OBJ file at path '{}'.", path.string()));
+  for (const auto& v : s.vertices)
+    file << format("v {} {} {}\n", v.position.x, v.position.y, v.position.z);
+  for (const auto& [i, j, k] : s.faces)
+    file << format("f {} {} {}\n", i + 1, j + 1, k + 1);
+  if (!file)
+    throw runtime_error(
+        format("Failed to write OBJ file at path '{}'.", path.string()));
+}
+
+/// Write the vertices and faces of the scene
+/// as binary little-endian PLY file like scanners do.
+///
+void write_binary_ply(const filesystem::path& path, const scene& s) {
+  fstream file{path, ios::out | ios::binary};
+  if (!file.is_open())
+    throw runtime_error(
+        format("Failed to create PLY file at path '{}'.", path.string()));
+  file << format(
+      "ply\n"
+      "format binary_little_endian 1.0\n"
+      "element vertex {}\n"
+      "property float x\n"
+      "property float y\n"
+      "property float z\n"
+      "element face {}\n"
+      "property list uchar int vertex_indices\n"
+      "end_header\n",
+      s.vertices.size(), s.faces.size());
+  for (const auto& v : s.vertices)
+    file.write((const char*)&v.position, sizeof(v.position));
+  const uint8 corners = 3;
+  for (const auto& f : s.faces) {
+    file.write((const char*)&corners, sizeof(corners));
+    file.write((const char*)f.data(), sizeof(f));
+  }
+  if (!file)
+    throw runtime_error(
+        format("Failed to write PLY file at path '{}'.", path.string()));
+}
+
+template <typename type>
+auto bytes_of(const vector<type>& v) noexcept -> size_t {
+  return v.size() * sizeof(type);
+}
+
+/// Print time, vertex throughput, and the bytes that are read or written
+/// per vertex together with the resulting memory throughput.
+///
+void report(czstring name, size_t vertices, size_t bytes, float64 seconds) {
+  println("  {:<20}{:>10.4f} s{:>10.2f} M vertices/s{:>8.1f} B/vertex"
+          "{:>10.1f} MB/s",
+          name, seconds, 1e-6 * vertices / seconds, float64(bytes) / vertices,
+          bytes / seconds / (1 << 20));
+}
+
+/// Generated meshes are already well ordered. So, reordering starts from
+/// a seeded random permutation like the arbitrary order of imported meshes.
+/// The draw throughput is given by the ACMR of a 16-entry FIFO cache.
+///
+void benchmark_reordering(const scene& mesh, int runs) {
+  auto shuffled = mesh;
+  mt19937 rng{0};
+  vector<scene::vertex_index> vertex_order(mesh.vertices.size());
+  std::iota(vertex_order.begin(), vertex_order.end(), 0);
+  std::ranges::shuffle(vertex_order, rng);
+  shuffled.reorder_vertices(vertex_order);
+  vector<scene::face_index> face_order(mesh.faces.size());
+  std::iota(face_order.begin(), face_order.end(), 0);
+  std::ranges::shuffle(face_order, rng);
+  shuffled.reorder_faces(face_order);
+
+  for (auto method : {reordering::none, reordering::morton, reordering::rcm,
+                      reordering::tipsify}) {
+    auto s = shuffled;
+    const auto stats = reorder(s, method);
+    const auto smoothing =
+        best_time(runs, [&] { s.smooth_normals(scales, encoding); });
+    println("  reorder {:<12}{:>10.4f} s    ACMR {:.3f} -> {:.3f}"
+            "    smooth_normals{:>10.4f} s",
+            reordering_string(method), stats.time.count(), stats.acmr_before,
+            stats.acmr_after, smoothing);
+  }
+}
+
+void benchmark_mesh(czstring name, scene mesh) {
+  const auto n = mesh.vertices.size();
+  println("{} with {} vertices and {} faces:", name, n, mesh.faces.size());
+  // Large meshes take long enough to be measured by a single run.
+  const auto runs = (n <= 1'000'000) ? 3 : 1;
+
+  const auto path = filesystem::temp_directory_path() /
+                    "exaggerated-shading-benchmark-mesh.stl";
+  write_binary_stl(path, mesh);
+  stl_surface stl{};
+  report("stl_surface", n, file_size(path),
+         best_time(runs, [&] { stl = stl_surface{path}; }));
+  filesystem::remove(path);
+
+  // OBJ and PLY files are parsed straight into the scene.
+  // Their vertices are already shared. So, there is no welding.
+  const auto native_import = [&](czstring label, const auto& write,
+                                 const auto& parse) {
+    const auto path = filesystem::temp_directory_path() /
+                      "exaggerated-shading-benchmark-mesh";
+    write(path, mesh);
+    scene imported{};
+    report(label, n, file_size(path), best_time(runs, [&] {
+             const mapped_file file{path};
+             imported = parse(file.content());
+           }));
+    filesystem::remove(path);
+    if (imported.faces.size() != mesh.faces.size())
+      throw runtime_error(
+          format("Failed to match faces of '{}' after {}.", name, label));
+  };
+  native_import("obj import", write_obj, scene_from_obj_data);
+  native_import("ply import", write_binary_ply, [](string_view content) {
+    return *scene_from_ply_data(content);
+  });
+
+  // Loading STL files restores the connectivity by welding.
+  scene loaded{};
+  const auto load_time = best_time(runs, [&] {
+    loaded = scene_from(stl);
+    loaded.weld_vertices();
+  });
+  report("scene_from + weld", n,
+         bytes_of(stl.triangles) + bytes_of(loaded.vertices) +
+             bytes_of(loaded.faces),
+         load_time);
+  if (loaded.vertices.size() != n)
+    throw runtime_error(format("Failed to weld '{}'. Expected {} vertices.",
+                               name, n));
+
+  // Normals are gathered over the vertex-face adjacency with one entry
+  // per corner and one offset per vertex. Building it needs another
+  // cursor per vertex. Face normals are kept as well.
+  const auto normal_bytes =
+      bytes_of(mesh.faces) + bytes_of(mesh.vertices) +
+      sizeof(vec3) * mesh.faces.size() +
+      sizeof(scene::face_index) * (3 * mesh.faces.size() + 2 * (n + 1));
+  auto normals = mesh;
+  report("normals by area", n, normal_bytes, best_time(runs, [&] {
+           normals.generate_normals(normal_weighting::area);
+         }));
+  report("normals by angle", n, normal_bytes, best_time(runs, [&] {
+           normals.generate_normals(normal_weighting::angle);
+         }));
+
+  report("generate_edges", n,
+         bytes_of(mesh.faces) + bytes_of(mesh.neighbor_offsets) +
+             bytes_of(mesh.neighbors) + bytes_of(mesh.neighbor_faces),
+         best_time(runs, [&] { mesh.generate_edges(); }));
+
+  report("smooth_normals", n,
+         bytes_of(mesh.vertices) + bytes_of(mesh.smoothed_normals),
+         best_time(runs, [&] { mesh.smooth_normals(scales, encoding); }));
+
+  aabb3 box{};
+  report("aabb_from", n, bytes_of(mesh.vertices),
+         best_time(runs, [&] { box = aabb_from(mesh); }));
+  if (!(box.radius() > 0))
+    throw runtime_error(format("Failed to bound '{}'.", name));
+
+  benchmark_reordering(mesh, runs);
+}
+
+}  // namespace
+
+void benchmark_geometry_kernels(size_t max_vertices) {
+  println("Geometry kernels with {} scales of {} normals:", scales,
+          normal_encoding_string(encoding));
+  for (const auto size : sizes) {
+    if (size > max_vertices) break;
+    println("\nRequested vertices: {}", size);
+    benchmark_mesh("icosphere", icosphere(size));
+    benchmark_mesh("noisy heightfield", noisy_heightfield(size));
+    benchmark_mesh("torus knot", torus_knot(size));
+  }
+}
+
+}  // namespace demo
@@ -0,0 +1,12 @@
+#pragma once
+#include <exaggerated-shading-demo/defaults.hpp>
+
+namespace demo {
+
+/// Time the geometry kernels of the demo on generated meshes
+/// with vertex counts from 10K up to 'max_vertices'.
+/// Every mesh is generated as icosphere, noisy heightfield, and torus knot.
+///
+void benchmark_geometry_kernels(size_t max_vertices);
+
+}  // namespace demo
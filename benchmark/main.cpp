@@ -0,0 +1,112 @@
+#include <random>
+//
+#include <exaggerated-shading-demo/stl_surface.hpp>
+//
+#include "geometry.hpp"
+#include "timing.hpp"
+
+using namespace demo;
+
+namespace {
+
+/// The former stream-based binary STL loader.
+/// It is kept as the reference for the memory-mapped implementation.
+///
+void legacy_load_from_binary_file(stl_surface& stl,
+                                  const filesystem::path& path) {
+  fstream file{path, ios::in | ios::binary};
+  if (!file.is_open())
+    throw runtime_error(
+        format("Failed to open STL file from path '{}'.", path.string()));
+  file.ignore(sizeof(stl_surface::header));
+  stl_surface::size_type size;
+  file.read((char*)&size, sizeof(size));
+  stl.triangles.resize(size);
+  for (auto& t : stl.triangles) {
+    file.read((char*)&t, sizeof(stl_surface::triangle));
+    file.ignore(sizeof(stl_surface::attribute_byte_count_type));
+  }
+}
+
+/// Write a binary STL file with random triangles.
+///
+void write_random_binary_stl(const filesystem::path& path,
+                             stl_surface::size_type size) {
+  fstream file{path, ios::out | ios::binary};
+  if (!file.is_open())
+    throw runtime_error(
+        format("Failed to create STL file at path '{}'.", path.string()));
+  const stl_surface::header header{};
+  file.write((const char*)header.data(), header.size());
+  file.write((const char*)&size, sizeof(size));
+  mt19937 rng{size};
+  uniform_real_distribution<float32> dist{-1.0f, 1.0f};
+  const stl_surface::attribute_byte_count_type attribute{};
+  for (stl_surface::size_type i = 0; i < size; ++i) {
+    array<float32, 12> t{};
+    for (auto& x : t) x = dist(rng);
+    file.write((const char*)t.data(), sizeof(t));
+    file.write((const char*)&attribute, sizeof(attribute));
+  }
+}
+
+void report(czstring name, size_t bytes, float64 seconds) {
+  println("{:<28}{:>12.4f} s{:>12.1f} MB/s", name, seconds,
+          bytes / seconds / (1 << 20));
+}
+
+void benchmark_binary_stl_loading(const filesystem::path& path) {
+  const auto bytes = file_size(path);
+  println("Binary STL loading of '{}' ({} bytes):", path.string(), bytes);
+
+  size_t legacy_size{};
+  report("  stream (legacy)", bytes, best_time(3, [&] {
+           stl_surface stl{};
+           legacy_load_from_binary_file(stl, path);
+           legacy_size = stl.triangles.size();
+         }));
+
+  size_t mapped_size{};
+  report("  memory-mapped", bytes, best_time(3, [&] {
+           stl_surface stl{path, stl_surface::binary};
+           mapped_size = stl.triangles.size();
+         }));
+
+  if (legacy_size != mapped_size)
+    throw runtime_error("Loaders disagree about the number of triangles.");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+  // Geometry kernels run on generated meshes up to an optional
+  // maximum vertex count. Large sizes need several gigabytes of memory.
+  //
+  if ((argc > 1) && (string_view{argv[1]} == "geometry")) {
+    benchmark_geometry_kernels((argc > 2) ? stoull(argv[2]) : 1'000'000);
+    return 0;
+  }
+
+  // Without a given file, benchmark against a generated one.
+  // The optional first argument is either an STL file
+  // or the number of triangles to generate.
+  //
+  stl_surface::size_type size = 1'000'000;
+  if (argc > 1) {
+    const filesystem::path path{argv[1]};
+    if (exists(path)) {
+      benchmark_binary_stl_loading(path);
+      return 0;
+    }
+    size = stoul(argv[1]);
+  }
+
+  const auto path = filesystem::temp_directory_path() /
+                    "exaggerated-shading-benchmark.stl";
+  write_random_binary_stl(path, size);
+  benchmark_binary_stl_loading(path);
+  filesystem::remove(path);
+} catch (const exception& e) {
+  println(stderr, "Error: {}", e.what());
+  return 1;
+}
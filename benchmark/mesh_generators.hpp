@@ -0,0 +1,169 @@
+#pragma once
+#include <random>
+#include <unordered_map>
+//
+#include <exaggerated-shading-demo/scene.hpp>
+
+namespace demo {
+
+/// Icosahedron that is subdivided by edge midpoints which are projected
+/// onto the unit sphere. Every level multiplies the faces by four.
+/// The level is chosen such that the vertex count 10 * 4^k + 2
+/// is closest to the requested count in logarithmic scale.
+///
+inline auto icosphere(size_t vertex_count) -> scene {
+  constexpr auto t = 1.618034f;  // golden ratio
+  vector<vec3> positions{
+      {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},  //
+      {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},  //
+      {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+  };
+  vector<scene::face> faces{
+      {0, 11, 5}, {0, 5, 1},  {0, 1, 7},   {0, 7, 10}, {0, 10, 11},
+      {1, 5, 9},  {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+      {3, 9, 4},  {3, 4, 2},  {3, 2, 6},   {3, 6, 8},  {3, 8, 9},
+      {4, 9, 5},  {2, 4, 11}, {6, 2, 10},  {8, 6, 7},  {9, 8, 1},
+  };
+  for (auto& p : positions) p = normalize(p);
+
+  const auto count = [](size_t level) {
+    return 10 * (size_t{1} << 2 * level) + 2;
+  };
+  size_t levels = 0;
+  while (std::log(float64(count(levels + 1)) / vertex_count) <
+         std::log(float64(vertex_count) / count(levels)))
+    ++levels;
+
+  for (size_t level = 0; level < levels; ++level) {
+    // Edges are shared by two faces. So, their midpoints are only
+    // created once and looked up by their sorted end points.
+    unordered_map<uint64_t, scene::vertex_index> midpoints{};
+    midpoints.reserve(3 * faces.size() / 2);
+    const auto midpoint = [&](scene::vertex_index i, scene::vertex_index j) {
+      const auto key = (uint64_t(std::min(i, j)) << 32) | std::max(i, j);
+      const auto [it, inserted] =
+          midpoints.try_emplace(key, scene::vertex_index(positions.size()));
+      if (inserted)
+        positions.push_back(normalize(positions[i] + positions[j]));
+      return it->second;
+    };
+    vector<scene::face> subdivided{};
+    subdivided.reserve(4 * faces.size());
+    for (const auto& [a, b, c] : faces) {
+      const auto ab = midpoint(a, b);
+      const auto bc = midpoint(b, c);
+      const auto ca = midpoint(c, a);
+      subdivided.push_back({a, ab, ca});
+      subdivided.push_back({b, bc, ab});
+      subdivided.push_back({c, ca, bc});
+      subdivided.push_back({ab, bc, ca});
+    }
+    faces = std::move(subdivided);
+  }
+
+  scene result{};
+  result.vertices.reserve(positions.size());
+  for (const auto& p : positions) result.vertices.push_back({p, p});
+  result.faces = std::move(faces);
+  return result;
+}
+
+/// Square grid of about the requested number of vertices
+/// over [-1, 1]^2 with smooth waves and uniform noise as height.
+/// The noise is seeded. So, every call generates the same surface.
+///
+inline auto noisy_heightfield(size_t vertex_count, uint32 seed = 0) -> scene {
+  const auto n = std::max(size_t(std::lround(std::sqrt(vertex_count))),
+                          size_t{2});
+  const auto h = 2.0f / (n - 1);
+  mt19937 rng{seed};
+  uniform_real_distribution<float32> noise{-0.1f * h, 0.1f * h};
+
+  scene result{};
+  vector<float32> heights(n * n);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      const auto x = -1.0f + h * j;
+      const auto y = -1.0f + h * i;
+      heights[i * n + j] =
+          0.1f * std::sin(6 * x) * std::cos(5 * y) + noise(rng);
+    }
+  }
+
+  // Normals are given by central differences of the heights.
+  const auto height = [&](size_t i, size_t j) {
+    return heights[std::min(i, n - 1) * n + std::min(j, n - 1)];
+  };
+  result.vertices.resize(n * n);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      const auto dx = height(i, j + 1) - height(i, (j > 0) ? j - 1 : 0);
+      const auto dy = height(i + 1, j) - height((i > 0) ? i - 1 : 0, j);
+      result.vertices[i * n + j] = {
+          .position = {-1.0f + h * j, -1.0f + h * i, heights[i * n + j]},
+          .normal = normalize(vec3{-dx, -dy, 2 * h})};
+    }
+  }
+
+  result.faces.reserve(2 * (n - 1) * (n - 1));
+  for (size_t i = 0; i + 1 < n; ++i) {
+    for (size_t j = 0; j + 1 < n; ++j) {
+      const auto v = scene::vertex_index(i * n + j);
+      const auto w = scene::vertex_index(v + n);
+      result.faces.push_back({v, v + 1, w + 1});
+      result.faces.push_back({v, w + 1, w});
+    }
+  }
+  return result;
+}
+
+/// Closed tube around a (p, q)-torus knot.
+/// The tube has 'sides' vertices around its circumference
+/// and as many rings along the knot as needed for the vertex count.
+///
+inline auto torus_knot(size_t vertex_count,
+                       uint32 p = 2,
+                       uint32 q = 3,
+                       uint32 sides = 16) -> scene {
+  const auto rings = std::max(vertex_count / sides, size_t{3});
+  const auto curve = [p, q](float32 t) {
+    const auto r = 2.0f + std::cos(q * t);
+    return vec3{r * std::cos(p * t), r * std::sin(p * t), -std::sin(q * t)};
+  };
+
+  scene result{};
+  result.vertices.resize(rings * sides);
+  for (size_t i = 0; i < rings; ++i) {
+    // Frame of the tube from the tangent and the position on the curve
+    const auto t = float32(2 * numbers::pi * i / rings);
+    const auto c = curve(t);
+    const auto tangent = normalize(curve(t + 1e-3f) - c);
+    const auto binormal = normalize(cross(tangent, c));
+    const auto normal = cross(binormal, tangent);
+    for (size_t j = 0; j < sides; ++j) {
+      const auto phi = 2 * pi * j / sides;
+      const auto n = std::cos(phi) * normal + std::sin(phi) * binormal;
+      result.vertices[i * sides + j] = {.position = c + 0.4f * n,
+                                        .normal = n};
+    }
+  }
+
+  result.faces.reserve(2 * rings * sides);
+  for (size_t i = 0; i < rings; ++i) {
+    for (size_t j = 0; j < sides; ++j) {
+      const auto index = [&](size_t a, size_t b) {
+        return scene::vertex_index((a % rings) * sides + (b % sides));
+      };
+      const auto v00 = index(i, j);
+      const auto v01 = index(i, j + 1);
+      const auto v10 = index(i + 1, j);
+      const auto v11 = index(i + 1, j + 1);
+      // Counter-clockwise around the outward normal
+      result.faces.push_back({v00, v01, v11});
+      result.faces.push_back({v00, v11, v10});
+    }
+  }
+  return result;
+}
+
+}  // namespace demo
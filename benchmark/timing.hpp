@@ -0,0 +1,21 @@
+#pragma once
+#include <chrono>
+//
+#include <exaggerated-shading-demo/defaults.hpp>
+
+namespace demo {
+
+/// Return the best wall-clock time in seconds of several runs.
+///
+auto best_time(int runs, auto&& f) -> float64 {
+  auto result = numeric_limits<float64>::infinity();
+  for (int i = 0; i < runs; ++i) {
+    const auto start = chrono::steady_clock::now();
+    f();
+    const auto end = chrono::steady_clock::now();
+    result = std::min(result, chrono::duration<float64>(end - start).count());
+  }
+  return result;
+}
+
+}  // namespace demo
@@ -100,4 +100,18 @@ class camera {
   float z_max = 1000.0f;
 };
 
+/// Unit vector given by horizontal coordinates in the basis of
+/// 'right', 'front', and 'up'. This is a variation of the standard
+/// spherical coordinates often used in astronomy.
+///
+inline auto horizontal_direction(float altitude,
+                                 float azimuth,
+                                 const vec3& right,
+                                 const vec3& front,
+                                 const vec3& up) noexcept -> vec3 {
+  return cos(altitude) * sin(azimuth) * right +  //
+         cos(altitude) * cos(azimuth) * front +  //
+         sin(altitude) * up;
+}
+
 }  // namespace demo
@@ -1,14 +1,23 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <format>
 #include <fstream>
 #include <limits>
+#include <map>
+#include <memory>
 #include <numbers>
+#include <optional>
 #include <print>
+#include <span>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 //
 #include "opengl/opengl.hpp"
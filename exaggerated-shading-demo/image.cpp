@@ -0,0 +1,18 @@
+#include "image.hpp"
+
+namespace demo {
+
+void save_ppm(const image& img, const filesystem::path& path) {
+  ofstream file{path, ios::binary | ios::trunc};
+  if (!file)
+    throw runtime_error(
+        format("Failed to open file '{}' for writing.", path.string()));
+  file << format("P6\n{} {}\n255\n", img.width, img.height);
+  file.write(reinterpret_cast<const char*>(img.pixels.data()),
+             img.pixels.size());
+  if (!file)
+    throw runtime_error(
+        format("Failed to write image to file '{}'.", path.string()));
+}
+
+}  // namespace demo
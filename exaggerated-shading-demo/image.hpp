@@ -0,0 +1,29 @@
+#pragma once
+#include "defaults.hpp"
+
+namespace demo {
+
+/// 8-bit RGB image with rows stored from top to bottom.
+///
+struct image {
+  uint32 width = 0;
+  uint32 height = 0;
+  vector<uint8> pixels{};
+
+  image() = default;
+  image(uint32 w, uint32 h) : width{w}, height{h}, pixels(3 * size_t{w} * h) {}
+
+  auto operator()(uint32 x, uint32 y) noexcept -> uint8* {
+    return &pixels[3 * (size_t{y} * width + x)];
+  }
+  auto operator()(uint32 x, uint32 y) const noexcept -> const uint8* {
+    return &pixels[3 * (size_t{y} * width + x)];
+  }
+};
+
+/// Write the image as binary Portable Pixmap (PPM) file.
+/// The format needs no external library and is read by most image tools.
+///
+void save_ppm(const image& img, const filesystem::path& path);
+
+}  // namespace demo
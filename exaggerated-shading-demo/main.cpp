@@ -1,9 +1,170 @@
+#include <charconv>
+//
+#include "software_rasterizer.hpp"
 #include "viewer.hpp"
 
-int main(int argc, char* argv[]) {
-  demo::viewer viewer{};
+namespace {
 
-  if (argc > 1) viewer.load_scene(argv[1]);
+using namespace demo;
 
-  viewer.run();
+void print_usage(czstring program) {
+  println(
+      "Usage: {} [options] [scene]\n"
+      "Options:\n"
+      "  --continuous       Redraw every frame, for example for profiling.\n"
+      "  --headless         Render offscreen without any window or display.\n"
+      "  --software         Render with the CPU rasterizer without OpenGL.\n"
+      "  --size WxH         Resolution in pixels. Default: 500x500\n"
+      "  --turntable N      Render N frames of a camera rotation to images.\n"
+      "  --output DIR       Directory of rendered images. Default: frames\n"
+      "  --benchmark N      Measure N frames along a fixed camera path.\n"
+      "  --report FILE      Write the benchmark report as JSON to FILE.\n"
+      "  --trace FILE       Write a Chrome trace of all phases on exit.\n"
+      "  --reorder METHOD   Reorder scenes for cache locality by none,\n"
+      "                     morton, rcm, or tipsify. Default: tipsify\n"
+      "  --gpu-smoothing    Smooth normals in a compute shader on the GPU.\n"
+      "  --check-smoothing  Compare normals smoothed on the GPU and the CPU.",
+      program);
+}
+
+auto parse_count(string_view str) -> uint {
+  uint result{};
+  const auto [ptr, ec] =
+      from_chars(str.data(), str.data() + str.size(), result);
+  if ((ec != errc{}) || (ptr != str.data() + str.size()) || (result == 0))
+    throw runtime_error(format("Failed to parse positive number '{}'.", str));
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+  bool continuous = false;
+  bool headless = false;
+  bool software = false;
+  uint width = 500;
+  uint height = 500;
+  uint turntable_frames = 0;
+  uint benchmark_frames = 0;
+  filesystem::path report{};
+  filesystem::path trace{};
+  reordering order = reordering::tipsify;
+  bool gpu_smoothing = false;
+  bool check_smoothing = false;
+  filesystem::path output = "frames";
+  vector<filesystem::path> scenes{};
+
+  for (int i = 1; i < argc; ++i) {
+    const string_view arg{argv[i]};
+    const auto value = [&]() -> string_view {
+      if (i + 1 >= argc)
+        throw runtime_error(format("Missing value for option '{}'.", arg));
+      return argv[++i];
+    };
+    if (arg == "--continuous")
+      continuous = true;
+    else if (arg == "--headless")
+      headless = true;
+    else if (arg == "--software")
+      software = true;
+    else if (arg == "--size") {
+      const auto size = value();
+      const auto x = size.find('x');
+      if (x == string_view::npos)
+        throw runtime_error(format("Failed to parse size '{}'.", size));
+      width = parse_count(size.substr(0, x));
+      height = parse_count(size.substr(x + 1));
+    } else if (arg == "--turntable")
+      turntable_frames = parse_count(value());
+    else if (arg == "--output")
+      output = value();
+    else if (arg == "--benchmark")
+      benchmark_frames = parse_count(value());
+    else if (arg == "--report")
+      report = value();
+    else if (arg == "--trace")
+      trace = value();
+    else if (arg == "--reorder")
+      order = reordering_from(value());
+    else if (arg == "--gpu-smoothing")
+      gpu_smoothing = true;
+    else if (arg == "--check-smoothing")
+      gpu_smoothing = check_smoothing = true;
+    else if (arg == "--help") {
+      print_usage(argv[0]);
+      return 0;
+    } else if (arg.starts_with("--"))
+      throw runtime_error(format("Unknown option '{}'.", arg));
+    else
+      scenes.emplace_back(arg);
+  }
+
+  // Recorded spans are only written when the program ends regularly.
+  const auto write_trace = [&] {
+    if (!trace.empty()) tracing::write_trace(trace);
+  };
+
+  // Without a display, there is nothing to interact with.
+  // So, headless and software runs always render something.
+  if ((headless || software) && (turntable_frames == 0) &&
+      (benchmark_frames == 0) && !check_smoothing)
+    turntable_frames = 1;
+
+  // The software rasterizer needs no OpenGL context at all.
+  // Scenes are processed with the same parameters as in the viewer.
+  if (software) {
+    if (scenes.empty())
+      throw runtime_error("Failed to render without any scene.");
+    constexpr uint32 scales = 10;
+    scene_loader loader{scenes.back(), scales, normal_encoding::octahedral,
+                        order};
+    loader.wait();
+    render_software_turntable(loader.take(), width, height, scales,
+                              turntable_frames, output);
+    write_trace();
+    return 0;
+  }
+
+  viewer viewer{width, height, headless};
+  viewer.set_continuous_rendering(continuous);
+  if (!trace.empty()) viewer.set_trace_path(trace);
+  viewer.set_reordering(order);
+  viewer.set_gpu_smoothing(gpu_smoothing);
+  for (const auto& scene : scenes) viewer.load_scene(scene);
+
+  // Both paths must agree up to rounding of the GPU.
+  // Headless runs on software drivers like llvmpipe are sufficient.
+  if (check_smoothing) {
+    constexpr float32 tolerance = 1e-3f;
+    const auto error = viewer.smoothing_error();
+    println("Maximum angle between normals smoothed on GPU and CPU: {:.2e} rad",
+            error);
+    write_trace();
+    return (error <= tolerance) ? 0 : 1;
+  }
+
+  if (turntable_frames > 0)
+    viewer.render_turntable(output, turntable_frames);
+
+  // Benchmarks run unattended and quit afterwards.
+  if (benchmark_frames > 0) {
+    const auto result = viewer.benchmark(benchmark_frames);
+    if (report.empty())
+      println("{}", result);
+    else {
+      ofstream file{report};
+      file << result << '\n';
+      if (!file)
+        throw runtime_error(format(
+            "Failed to write benchmark report to '{}'.", report.string()));
+    }
+    write_trace();
+    return 0;
+  }
+
+  if (not headless) viewer.run();
+  write_trace();
+} catch (const exception& e) {
+  println("Error: {}\nSee '--help' for usage.", e.what());
+  return 1;
 }
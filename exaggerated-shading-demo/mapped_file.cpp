@@ -0,0 +1,118 @@
+#include "mapped_file.hpp"
+//
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace demo {
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(const filesystem::path& path) {
+  const auto file =
+      ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw runtime_error(
+        format("Failed to open file from path '{}'.", path.string()));
+
+  LARGE_INTEGER size{};
+  if (!::GetFileSizeEx(file, &size)) {
+    ::CloseHandle(file);
+    throw runtime_error(
+        format("Failed to query size of file '{}'.", path.string()));
+  }
+  bytes = size.QuadPart;
+
+  // Mapping an empty file is not allowed.
+  // An empty mapping is represented by a null pointer.
+  //
+  if (bytes == 0) {
+    ::CloseHandle(file);
+    return;
+  }
+
+  const auto mapping =
+      ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  ::CloseHandle(file);
+  // The view keeps its own reference to the mapping.
+  const auto addr =
+      mapping ? ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (mapping) ::CloseHandle(mapping);
+  if (!addr) {
+    bytes = 0;
+    throw runtime_error(
+        format("Failed to memory-map file '{}'.", path.string()));
+  }
+  ptr = static_cast<const char*>(addr);
+}
+
+mapped_file::~mapped_file() noexcept {
+  if (ptr) ::UnmapViewOfFile(ptr);
+}
+
+#else
+
+mapped_file::mapped_file(const filesystem::path& path) {
+  const auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    throw runtime_error(
+        format("Failed to open file from path '{}'.", path.string()));
+
+  struct stat info{};
+  if (::fstat(fd, &info) == -1) {
+    ::close(fd);
+    throw runtime_error(
+        format("Failed to query size of file '{}'.", path.string()));
+  }
+  bytes = info.st_size;
+
+  // Mapping an empty file is not allowed.
+  // An empty mapping is represented by a null pointer.
+  //
+  if (bytes == 0) {
+    ::close(fd);
+    return;
+  }
+
+  const auto addr = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    bytes = 0;
+    throw runtime_error(
+        format("Failed to memory-map file '{}'.", path.string()));
+  }
+  ptr = static_cast<const char*>(addr);
+
+  // Files are mostly parsed front to back.
+  // So, let the kernel read ahead aggressively.
+  ::madvise(addr, bytes, MADV_SEQUENTIAL);
+}
+
+mapped_file::~mapped_file() noexcept {
+  if (ptr) ::munmap(const_cast<char*>(ptr), bytes);
+}
+
+#endif
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : ptr{other.ptr}, bytes{other.bytes} {
+  other.ptr = nullptr;
+  other.bytes = 0;
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+  swap(ptr, other.ptr);
+  swap(bytes, other.bytes);
+  return *this;
+}
+
+}  // namespace demo
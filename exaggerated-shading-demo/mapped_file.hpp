@@ -0,0 +1,37 @@
+#pragma once
+#include "defaults.hpp"
+
+namespace demo {
+
+/// Read-only memory mapping of a whole file.
+/// The content stays valid as long as the object lives
+/// and is meant to be parsed in place without any copies.
+///
+class mapped_file {
+ public:
+  constexpr mapped_file() noexcept = default;
+  explicit mapped_file(const filesystem::path& path);
+  ~mapped_file() noexcept;
+
+  // Mappings are unique resources.
+  // So, copying is not allowed and moving does not throw.
+  //
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+  mapped_file(mapped_file&& other) noexcept;
+  mapped_file& operator=(mapped_file&& other) noexcept;
+
+  auto data() const noexcept -> const char* { return ptr; }
+  auto size() const noexcept -> size_t { return bytes; }
+  auto empty() const noexcept -> bool { return bytes == 0; }
+
+  /// The raw file content.
+  ///
+  auto content() const noexcept -> string_view { return {ptr, bytes}; }
+
+ private:
+  const char* ptr = nullptr;
+  size_t bytes = 0;
+};
+
+}  // namespace demo
@@ -0,0 +1,116 @@
+#pragma once
+#include <glm/gtc/packing.hpp>
+//
+#include "defaults.hpp"
+
+namespace demo {
+
+/// Storage formats for unit normals in CPU and GPU buffers.
+/// Every encoded normal consists of 32-bit words.
+/// The enumeration values are used as 'NORMAL_ENCODING' in shaders.
+///
+enum class normal_encoding : uint32 {
+  float4 = 0,      // four 32-bit floats with unused w component
+  octahedral = 1,  // octahedral projection as two 16-bit snorm values
+  half4 = 2,       // four 16-bit floats with unused w component
+};
+
+constexpr auto words_per_normal(normal_encoding encoding) noexcept -> size_t {
+  switch (encoding) {
+    case normal_encoding::octahedral:
+      return 1;
+    case normal_encoding::half4:
+      return 2;
+    default:
+      return 4;
+  }
+}
+
+constexpr auto normal_encoding_string(normal_encoding encoding) noexcept
+    -> czstring {
+  switch (encoding) {
+    case normal_encoding::octahedral:
+      return "octahedral snorm16x2";
+    case normal_encoding::half4:
+      return "half4";
+    default:
+      return "float4";
+  }
+}
+
+namespace detail {
+
+inline auto octahedral_unwrap(vec2 p) noexcept -> vec3 {
+  vec3 n{p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y)};
+  const auto t = std::max(-n.z, 0.0f);
+  n.x += (n.x >= 0.0f) ? -t : t;
+  n.y += (n.y >= 0.0f) ? -t : t;
+  return normalize(n);
+}
+
+}  // namespace detail
+
+inline auto decode_octahedral(uint32 word) noexcept -> vec3 {
+  return detail::octahedral_unwrap(glm::unpackSnorm2x16(word));
+}
+
+/// Project the unit normal onto the octahedron and unfold it into a square.
+/// Of the four neighboring snorm16 grid points,
+/// the one with the smallest decoding error is chosen.
+///
+inline auto encode_octahedral(vec3 n) noexcept -> uint32 {
+  vec2 p = vec2{n.x, n.y} / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+  if (n.z < 0.0f) {
+    const auto sign = [](float x) { return (x >= 0.0f) ? 1.0f : -1.0f; };
+    p = vec2{(1.0f - std::abs(p.y)) * sign(p.x),
+             (1.0f - std::abs(p.x)) * sign(p.y)};
+  }
+  constexpr auto scale = 32767.0f;
+  uint32 result = 0;
+  auto best = -infinity;
+  for (int i = 0; i < 4; ++i) {
+    const vec2 q{((i & 1) ? std::ceil(p.x * scale) : std::floor(p.x * scale)),
+                 ((i & 2) ? std::ceil(p.y * scale) : std::floor(p.y * scale))};
+    const auto word = glm::packSnorm2x16(q / scale);
+    const auto d = dot(decode_octahedral(word), n);
+    if (d <= best) continue;
+    best = d;
+    result = word;
+  }
+  return result;
+}
+
+/// Write the encoded normal to 'words_per_normal(encoding)' words.
+///
+inline void encode(normal_encoding encoding, vec3 n, uint32* words) noexcept {
+  switch (encoding) {
+    case normal_encoding::octahedral:
+      words[0] = encode_octahedral(n);
+      break;
+    case normal_encoding::half4:
+      words[0] = glm::packHalf2x16({n.x, n.y});
+      words[1] = glm::packHalf2x16({n.z, 0.0f});
+      break;
+    default:
+      words[0] = bit_cast<uint32>(n.x);
+      words[1] = bit_cast<uint32>(n.y);
+      words[2] = bit_cast<uint32>(n.z);
+      words[3] = bit_cast<uint32>(0.0f);
+  }
+}
+
+inline auto decode(normal_encoding encoding, const uint32* words) noexcept
+    -> vec3 {
+  switch (encoding) {
+    case normal_encoding::octahedral:
+      return decode_octahedral(words[0]);
+    case normal_encoding::half4:
+      return {glm::unpackHalf2x16(words[0]),
+              glm::unpackHalf2x16(words[1]).x};
+    default:
+      return {bit_cast<float32>(words[0]), bit_cast<float32>(words[1]),
+              bit_cast<float32>(words[2])};
+  }
+}
+
+}  // namespace demo
@@ -0,0 +1,185 @@
+#include "obj_import.hpp"
+//
+#include <charconv>
+
+namespace demo {
+
+namespace {
+
+constexpr auto is_blank(char c) noexcept {
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\v') ||
+         (c == '\f');
+}
+
+/// Allocation-free tokenizer for a single line of an OBJ file.
+/// Tokens are views into the underlying file content.
+///
+struct obj_line_parser {
+  const char* it;
+  const char* end;
+
+  void skip_blank() noexcept {
+    while ((it != end) && is_blank(*it)) ++it;
+  }
+
+  auto token() noexcept -> string_view {
+    skip_blank();
+    const auto first = it;
+    while ((it != end) && !is_blank(*it)) ++it;
+    return {first, it};
+  }
+
+  auto done() noexcept -> bool {
+    skip_blank();
+    return it == end;
+  }
+
+  /// Number of remaining tokens in the line.
+  ///
+  auto count() noexcept -> size_t {
+    size_t result = 0;
+    while (!token().empty()) ++result;
+    return result;
+  }
+
+  void read(float32& x) {
+    skip_blank();
+    // 'from_chars' does not accept an explicit plus sign.
+    if ((it != end) && (*it == '+')) ++it;
+    const auto [ptr, error] = from_chars(it, end, x);
+    if (error != errc{})
+      throw runtime_error{
+          "Failed to parse floating-point number in OBJ file."};
+    it = ptr;
+  }
+
+  /// Read the vertex index of a face corner given as 'v', 'v/t',
+  /// 'v//n', or 'v/t/n'. Texture and normal indices are skipped.
+  /// Negative indices are relative to the 'defined' vertices so far.
+  ///
+  auto read_index(size_t defined, size_t total) -> scene::vertex_index {
+    skip_blank();
+    int64_t index{};
+    const auto [ptr, error] = from_chars(it, end, index);
+    if (error != errc{})
+      throw runtime_error{"Failed to parse vertex index in OBJ file."};
+    it = ptr;
+    while ((it != end) && !is_blank(*it)) ++it;
+    const auto result = (index < 0) ? int64_t(defined) + index : index - 1;
+    if ((index == 0) || (result < 0) || (result >= int64_t(total)))
+      throw runtime_error{
+          format("Failed to resolve vertex index {} in OBJ file with {} "
+                 "vertices.",
+                 index, total)};
+    return scene::vertex_index(result);
+  }
+};
+
+/// Call 'f(keyword, parser)' for every line that starts in [first, last).
+/// The parser is restricted to the rest of the line after the keyword
+/// up to the start of a comment.
+///
+void for_each_line(string_view content, size_t first, size_t last, auto&& f) {
+  while (first < last) {
+    const auto line_end = std::min(content.find('\n', first), content.size());
+    // Comments may follow any statement and end the line.
+    const auto line = content.substr(first, line_end - first);
+    const auto comment = std::min(line.find('#'), line.size());
+    obj_line_parser parser{line.data(), line.data() + comment};
+    const auto keyword = parser.token();
+    if (!keyword.empty()) f(keyword, parser);
+    first = line_end + 1;
+  }
+}
+
+}  // namespace
+
+auto scene_from_obj_data(string_view content) -> scene {
+  DEMO_TRACE_SCOPE("scene_from_obj_data");
+
+  // Split the content into chunks at line boundaries.
+  // Every chunk is then parsed independently on its own thread.
+  //
+  constexpr size_t grain = size_t{1} << 20;
+  const auto chunks =
+      std::clamp(content.size() / grain, size_t{1}, thread_count());
+  const auto next_line = [&](size_t first) {
+    const auto pos = content.find('\n', first);
+    return (pos == string_view::npos) ? content.size() : pos + 1;
+  };
+  vector<size_t> bounds(chunks + 1);
+  bounds[chunks] = content.size();
+  for (size_t i = 1; i < chunks; ++i)
+    bounds[i] =
+        std::max(bounds[i - 1], next_line(i * content.size() / chunks));
+
+  // The first pass only counts vertices and triangles per chunk.
+  // Their prefix sums are the offsets at which every chunk writes
+  // its results straight into the scene in the second pass.
+  //
+  vector<size_t> vertex_offsets(chunks + 1);
+  vector<size_t> face_offsets(chunks + 1);
+  parallel_for_chunks(chunks, [&](size_t i) {
+    for_each_line(
+        content, bounds[i], bounds[i + 1],
+        [&](string_view keyword, obj_line_parser& parser) {
+          if (keyword == "v")
+            ++vertex_offsets[i + 1];
+          else if (keyword == "f") {
+            const auto corners = parser.count();
+            if (corners < 3)
+              throw runtime_error{
+                  "Failed to parse face with less than three vertices "
+                  "in OBJ file."};
+            face_offsets[i + 1] += corners - 2;
+          }
+        });
+  });
+  for (size_t i = 0; i < chunks; ++i) {
+    vertex_offsets[i + 1] += vertex_offsets[i];
+    face_offsets[i + 1] += face_offsets[i];
+  }
+  const auto vertex_count = vertex_offsets[chunks];
+  const auto face_count = face_offsets[chunks];
+  if (std::max(vertex_count, face_count) >= scene::invalid)
+    throw runtime_error{
+        format("Failed to index {} vertices and {} faces of OBJ file "
+               "with 32 bits.",
+               vertex_count, face_count)};
+
+  struct scene scene{};
+  scene.vertices.resize(vertex_count);
+  scene.faces.resize(face_count);
+  parallel_for_chunks(chunks, [&](size_t i) {
+    auto vid = vertex_offsets[i];
+    auto fid = face_offsets[i];
+    for_each_line(
+        content, bounds[i], bounds[i + 1],
+        [&](string_view keyword, obj_line_parser& parser) {
+          if (keyword == "v") {
+            auto& p = scene.vertices[vid++].position;
+            parser.read(p.x);
+            parser.read(p.y);
+            parser.read(p.z);
+          } else if (keyword == "f") {
+            // Polygons are triangulated as fans around their first vertex.
+            const auto first = parser.read_index(vid, vertex_count);
+            auto previous = parser.read_index(vid, vertex_count);
+            while (!parser.done()) {
+              const auto current = parser.read_index(vid, vertex_count);
+              scene.faces[fid++] = {first, previous, current};
+              previous = current;
+            }
+          }
+        });
+  });
+
+  // Faces that collapse to a line or a point have no normal
+  // and would introduce loops into the adjacency.
+  erase_if(scene.faces, [](const auto& f) {
+    return (f[0] == f[1]) || (f[1] == f[2]) || (f[2] == f[0]);
+  });
+  return scene;
+}
+
+}  // namespace demo
@@ -0,0 +1,14 @@
+#pragma once
+#include "scene.hpp"
+
+namespace demo {
+
+/// Parse the raw content of a Wavefront OBJ file that has already been
+/// read or memory-mapped directly into a scene. Only vertex positions
+/// and faces are read. Polygons are triangulated as fans. Vertex normals
+/// are left zero to be generated from the faces. All other statements,
+/// like texture coordinates, groups, and materials, are ignored.
+///
+auto scene_from_obj_data(string_view content) -> scene;
+
+}  // namespace demo
@@ -0,0 +1,129 @@
+#include "offscreen.hpp"
+//
+#ifdef __linux__
+// Keep X11 macros out of the translation unit.
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+//
+#include <glbinding/glbinding.h>
+
+namespace demo {
+
+#ifdef __linux__
+
+namespace {
+
+auto surfaceless_display() -> EGLDisplay {
+  // Prefer Mesa's surfaceless platform that needs no display server at all.
+  // Otherwise, fall back to the default display of the EGL implementation.
+  const auto get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+          eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (get_platform_display) {
+    const auto display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                              EGL_DEFAULT_DISPLAY, nullptr);
+    if (display != EGL_NO_DISPLAY) return display;
+  }
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+}  // namespace
+
+egl_context::egl_context() {
+  display = surfaceless_display();
+  if (display == EGL_NO_DISPLAY)
+    throw runtime_error("Failed to get EGL display.");
+
+  EGLint major, minor;
+  if (eglInitialize(display, &major, &minor) != EGL_TRUE)
+    throw runtime_error("Failed to initialize EGL display.");
+
+  if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+    eglTerminate(display);
+    throw runtime_error("Failed to bind OpenGL API for EGL.");
+  }
+
+  // Rendering only happens into framebuffer objects.
+  // So, the configuration does not need any surface type.
+  const EGLint config_attributes[] = {
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,  //
+      EGL_SURFACE_TYPE, 0,                  //
+      EGL_NONE,
+  };
+  EGLConfig config;
+  EGLint configs = 0;
+  eglChooseConfig(display, config_attributes, &config, 1, &configs);
+
+  const EGLint context_attributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 4,  //
+      EGL_CONTEXT_MINOR_VERSION, 6,  //
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE,
+  };
+  // With 'EGL_KHR_no_config_context', no configuration is required.
+  if (configs == 0) config = EGL_NO_CONFIG_KHR;
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                             context_attributes);
+  if (context == EGL_NO_CONTEXT) {
+    eglTerminate(display);
+    throw runtime_error("Failed to create OpenGL 4.6 core context with EGL.");
+  }
+
+  if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) !=
+      EGL_TRUE) {
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+    throw runtime_error("Failed to make surfaceless EGL context current.");
+  }
+
+  glbinding::initialize([](const char* name) {
+    return reinterpret_cast<glbinding::ProcAddress>(eglGetProcAddress(name));
+  });
+}
+
+egl_context::~egl_context() noexcept {
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(display, context);
+  eglTerminate(display);
+}
+
+#else
+
+// EGL is only linked on Linux. Elsewhere, headless runs fail early.
+egl_context::egl_context() {
+  throw runtime_error(
+      "Failed to create OpenGL context without a window. Headless "
+      "rendering is not supported on this platform.");
+}
+
+egl_context::~egl_context() noexcept {}
+
+#endif
+
+offscreen_framebuffer::offscreen_framebuffer(uint32 width, uint32 height)
+    : w{width}, h{height} {
+  color.allocate(GL_RGBA8, w, h);
+  depth.allocate(GL_DEPTH24_STENCIL8, w, h);
+  framebuffer.attach(GL_COLOR_ATTACHMENT0, color);
+  framebuffer.attach(GL_DEPTH_STENCIL_ATTACHMENT, depth);
+  if (not framebuffer.complete())
+    throw runtime_error("Failed to create complete offscreen framebuffer.");
+  framebuffer.bind();
+}
+
+auto read_pixels(uint32 width, uint32 height) -> image {
+  image result{width, height};
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadnPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE,
+                result.pixels.size(), result.pixels.data());
+  // OpenGL stores the bottom row first.
+  const auto row = 3 * size_t{width};
+  for (uint32 y = 0; y < height / 2; ++y)
+    std::swap_ranges(result(0, y), result(0, y) + row,
+                     result(0, height - 1 - y));
+  return result;
+}
+
+}  // namespace demo
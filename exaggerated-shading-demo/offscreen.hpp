@@ -0,0 +1,56 @@
+#pragma once
+#include "defaults.hpp"
+#include "image.hpp"
+
+namespace demo {
+
+/// OpenGL 4.6 core context that needs neither a window nor a display.
+/// It is created by EGL without any surface, for example on top of
+/// Mesa's software rasterizer on machines without a GPU.
+/// On construction, the context is made current and OpenGL is loaded.
+/// EGL is only used on Linux. On other platforms, construction throws.
+///
+class egl_context {
+ public:
+  egl_context();
+  ~egl_context() noexcept;
+
+  // The context is bound to the constructing thread.
+  // So, it can neither be copied nor moved.
+  //
+  egl_context(const egl_context&) = delete;
+  egl_context& operator=(const egl_context&) = delete;
+
+ private:
+  // Opaque 'EGLDisplay' and 'EGLContext' handles
+  // to not leak EGL headers into every translation unit.
+  void* display = nullptr;
+  void* context = nullptr;
+};
+
+/// Framebuffer with color and depth renderbuffers of fixed size.
+/// Without a window, it is the target of all draw calls.
+///
+class offscreen_framebuffer {
+ public:
+  offscreen_framebuffer(uint32 width, uint32 height);
+
+  auto width() const noexcept { return w; }
+  auto height() const noexcept { return h; }
+
+  void bind() const noexcept { framebuffer.bind(); }
+
+ private:
+  uint32 w;
+  uint32 h;
+  opengl::renderbuffer color{};
+  opengl::renderbuffer depth{};
+  opengl::framebuffer framebuffer{};
+};
+
+/// Read the color content of the currently bound read framebuffer.
+/// The rows are flipped such that the image starts at the top.
+///
+auto read_pixels(uint32 width, uint32 height) -> image;
+
+}  // namespace demo
@@ -83,32 +83,101 @@ struct buffer_base : object {
     assign(&value, 1);
   }
 
-  // void alloc(size_type size) const noexcept {
-  //   assign(static_cast<const void*>(nullptr), size);
-  // }
-
-  // void write(const void* data,
-  //            size_type size,
-  //            size_type offset = 0) const noexcept {
-  //   // assert(offset + size <= self.size());
-  //   glBufferSubData(buffer_type, offset, size, data);
-  // }
-
-  // void write(const auto* data,
-  //            size_type size,
-  //            size_type offset = 0) const noexcept {
-  //   write(static_cast<const void*>(data),  //
-  //         size * sizeof(data[0]), offset);
-  // }
-
-  // void write(const std::ranges::contiguous_range auto& range,
-  //            size_type offset = 0) const noexcept {
-  //   write(ranges::data(range), ranges::size(range), offset);
-  // }
-
-  // void write(const transferable auto& v, size_type offset = 0) const noexcept {
-  //   write(&v, 1, offset);
-  // }
+  /// Reallocate the data store with the given size in bytes.
+  /// Its content is undefined.
+  ///
+  void alloc(size_type size) const noexcept {
+    assign(static_cast<const void*>(nullptr), size);
+  }
+
+  /// Allocate an immutable data store with the given size in bytes.
+  /// Afterwards, the store can neither be resized nor reallocated
+  /// by 'assign' or 'alloc'. Only 'write' and mappings change its content
+  /// if permitted by 'flags'. If 'data' is null, the content is undefined.
+  ///
+  void allocate_storage(size_type size,
+                        BufferStorageMask flags = GL_DYNAMIC_STORAGE_BIT,
+                        const void* data = nullptr) const noexcept {
+    glNamedBufferStorage(native_handle(), size, data, flags);
+  }
+
+  /// Allocate an immutable data store initialized by the given range.
+  ///
+  void allocate_storage(
+      const std::ranges::contiguous_range auto& range,
+      BufferStorageMask flags = GL_DYNAMIC_STORAGE_BIT) const noexcept {
+    allocate_storage(ranges::size(range) * sizeof(ranges::data(range)[0]),
+                     flags, ranges::data(range));
+  }
+
+  /// Overwrite a sub-range of the data store starting at the given offset
+  /// in bytes without reallocating it. The range must lie inside the store.
+  /// Immutable stores need to be created with 'GL_DYNAMIC_STORAGE_BIT'.
+  ///
+  void write(const void* data,
+             size_type size,
+             offset_type offset = 0) const noexcept {
+    glNamedBufferSubData(native_handle(), offset, size, data);
+  }
+
+  void write(const auto* data,
+             size_type size,
+             offset_type offset = 0) const noexcept {
+    write(static_cast<const void*>(data),  //
+          size * sizeof(data[0]), offset);
+  }
+
+  void write(const std::ranges::contiguous_range auto& range,
+             offset_type offset = 0) const noexcept {
+    write(ranges::data(range), ranges::size(range), offset);
+  }
+
+  template <transferable type>
+    requires(!std::ranges::contiguous_range<type>)  //
+  void write(const type& value, offset_type offset = 0) const noexcept {
+    write(&value, 1, offset);
+  }
+
+  /// Read a sub-range of the data store starting at the given offset
+  /// in bytes back into client memory.
+  ///
+  void read(void* data,
+            size_type size,
+            offset_type offset = 0) const noexcept {
+    glGetNamedBufferSubData(native_handle(), offset, size, data);
+  }
+
+  void read(auto* data,
+            size_type size,
+            offset_type offset = 0) const noexcept {
+    read(static_cast<void*>(data),  //
+         size * sizeof(data[0]), offset);
+  }
+
+  /// Copy a range given in bytes from another buffer into this one.
+  /// The data stays on the GPU and is never read back to client memory.
+  ///
+  void copy(const buffer_base& source,
+            offset_type read_offset,
+            offset_type write_offset,
+            size_type size) const noexcept {
+    glCopyNamedBufferSubData(source.native_handle(), native_handle(),
+                             read_offset, write_offset, size);
+  }
+
+  /// Map a range of the data store given in bytes into client memory.
+  /// Returns null if the mapping fails.
+  ///
+  auto map(offset_type offset,
+           size_type size,
+           BufferAccessMask access) const noexcept -> void* {
+    return glMapNamedBufferRange(native_handle(), offset, size, access);
+  }
+
+  /// Release the mapping of the data store.
+  /// Persistent mappings do not need to be released before use.
+  ///
+  void unmap() const noexcept { glUnmapNamedBuffer(native_handle()); }
 };
 
 ///
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <concepts>
 #include <cstdint>
@@ -177,12 +178,14 @@ struct unique : type {
   constexpr unique& operator=(const unique&) = delete;
   // Moving must implemented manually.
   // otherwise, `other` is not invalidated and the objects gets destroyed right away.
-  constexpr unique(unique&& other) noexcept : base{other.native_handle()} {
+  // The whole base is moved to also transfer state cached alongside the handle.
+  constexpr unique(unique&& other) noexcept
+      : base{std::move(static_cast<base&>(other))} {
     other.handle = 0;
   }
   constexpr unique& operator=(unique&& other) noexcept {
     using std::swap;
-    swap(handle, other.handle);
+    swap(static_cast<base&>(*this), static_cast<base&>(other));
     return *this;
   }
 };
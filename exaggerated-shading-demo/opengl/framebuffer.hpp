@@ -0,0 +1,108 @@
+#pragma once
+#include "defaults.hpp"
+
+namespace demo::opengl {
+
+///
+///
+struct renderbuffer_base : object {
+  /// Base Type and Constructors
+  ///
+  using base = object;
+  using base::base;
+
+  /// The default constructor obtains a valid OpenGL renderbuffer handle.
+  /// If acquiring the handle fails, it throws a 'resource_acquisition_error'.
+  ///
+  static auto create() -> renderbuffer_base {
+    native_handle_type handle;
+    glCreateRenderbuffers(1, &handle);
+    return renderbuffer_base{handle};
+  }
+
+  /// Renderbuffers that are attached to the currently bound framebuffer
+  /// are detached from it before they are deleted.
+  ///
+  static void destroy(renderbuffer_base& resource) noexcept {
+    // Silently ignores zero and names that do
+    // not correspond to existing renderbuffer objects.
+    glDeleteRenderbuffers(1, &resource.handle);
+  }
+
+  ///
+  ///
+  bool valid() const noexcept { return glIsRenderbuffer(handle) == GL_TRUE; }
+
+  /// Allocate storage of the given format and size in pixels.
+  ///
+  void allocate(GLenum format, GLsizei width, GLsizei height) const noexcept {
+    glNamedRenderbufferStorage(native_handle(), format, width, height);
+  }
+};
+
+///
+///
+STRICT_FINAL_USING(renderbuffer, unique<renderbuffer_base>);
+
+///
+///
+STRICT_FINAL_USING(renderbuffer_view, view<renderbuffer>);
+
+///
+///
+struct framebuffer_base : object {
+  /// Base Type and Constructors
+  ///
+  using base = object;
+  using base::base;
+
+  /// The default constructor obtains a valid OpenGL framebuffer handle.
+  /// If acquiring the handle fails, it throws a 'resource_acquisition_error'.
+  ///
+  static auto create() -> framebuffer_base {
+    native_handle_type handle;
+    glCreateFramebuffers(1, &handle);
+    return framebuffer_base{handle};
+  }
+
+  /// If a framebuffer that is currently bound is deleted,
+  /// the binding reverts to zero, the default framebuffer.
+  ///
+  static void destroy(framebuffer_base& resource) noexcept {
+    glDeleteFramebuffers(1, &resource.handle);
+  }
+
+  ///
+  ///
+  bool valid() const noexcept { return glIsFramebuffer(handle) == GL_TRUE; }
+
+  ///
+  ///
+  void bind(GLenum target = GL_FRAMEBUFFER) const noexcept {
+    glBindFramebuffer(target, native_handle());
+  }
+
+  ///
+  ///
+  void attach(GLenum attachment, renderbuffer_view buffer) const noexcept {
+    glNamedFramebufferRenderbuffer(native_handle(), attachment,
+                                   GL_RENDERBUFFER, buffer.native_handle());
+  }
+
+  /// Checks whether all attachments allow for rendering.
+  ///
+  bool complete() const noexcept {
+    return glCheckNamedFramebufferStatus(native_handle(), GL_FRAMEBUFFER) ==
+           GL_FRAMEBUFFER_COMPLETE;
+  }
+};
+
+///
+///
+STRICT_FINAL_USING(framebuffer, unique<framebuffer_base>);
+
+///
+///
+STRICT_FINAL_USING(framebuffer_view, view<framebuffer>);
+
+}  // namespace demo::opengl
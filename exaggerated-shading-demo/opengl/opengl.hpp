@@ -1,5 +1,9 @@
 #pragma once
 #include "buffer.hpp"
+#include "framebuffer.hpp"
 #include "program.hpp"
+#include "query.hpp"
+#include "ring_buffer.hpp"
+#include "uniform_buffer.hpp"
 #include "vector.hpp"
 #include "vertex_array.hpp"
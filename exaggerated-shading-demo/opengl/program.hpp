@@ -12,6 +12,33 @@ struct program_base;
 template <typename type>
 concept program_like = similar_to<type, program_base>;
 
+/// 64-bit FNV-1a hash of uniform names.
+///
+constexpr auto uniform_hash(std::string_view name) noexcept -> uint64 {
+  uint64 hash = 0xcbf29ce484222325ull;
+  for (auto c : name) {
+    hash ^= static_cast<uint8>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+/// Name of a uniform variable together with its hash.
+/// For string literals, the hash is computed at compile time.
+/// Other strings need to be null-terminated and explicitly converted.
+///
+struct uniform_identifier {
+  czstring name;
+  uint64 hash;
+
+  template <size_t n>
+  consteval uniform_identifier(const char (&str)[n]) noexcept
+      : name{str}, hash{uniform_hash({str, n - 1})} {}
+
+  explicit constexpr uniform_identifier(czstring str) noexcept
+      : name{str}, hash{uniform_hash(str)} {}
+};
+
 ///
 ///
 struct program_base : object {
@@ -79,11 +106,12 @@ struct program_base : object {
 
   void validate() const noexcept { glValidateProgram(native_handle()); }
 
-  void link(shader_like auto&&... obj) const noexcept {
+  void link(shader_like auto&&... obj) noexcept {
     // link cannot throw. RAII/scope utility does not need to be applied.
     (glAttachShader(native_handle(), obj.native_handle()), ...);
     glLinkProgram(native_handle());
     (glDetachShader(native_handle(), obj.native_handle()), ...);
+    cache_uniform_locations();
   }
 
   template <shader_like... shader_types>
@@ -113,7 +141,7 @@ struct program_base : object {
   template <shader_like... types>
   build_status(types&&...) -> build_status<opengl::decay<types>...>;
 
-  auto build(shader_like auto&&... obj) const noexcept {
+  auto build(shader_like auto&&... obj) noexcept {
     // build_status status{std::tuple{fwd(std::forward<decltype(obj)>(obj))...}};
     // build_status status{fwd(std::forward<decltype(obj)>(obj))...};
     build_status status{opengl::forward<decltype(obj)>(obj)...};
@@ -138,23 +166,88 @@ struct program_base : object {
   void use() const noexcept { glUseProgram(native_handle()); }
 
  private:
-  auto uniform_location(czstring name) noexcept {
-    return glGetUniformLocation(native_handle(), name);
+  // Locations of all active uniforms are queried once after linking
+  // and looked up by the hash of their names afterwards.
+  // So, setting uniforms does not need any driver round-trips.
+  // Names with colliding hashes are marked to be queried every time.
+  //
+  static constexpr GLint colliding_location = -2;
+  std::vector<std::pair<uint64, GLint>> uniform_locations{};
+  bool uniform_locations_cached = false;
+
+  void cache_uniform_locations() {
+    uniform_locations.clear();
+    uniform_locations_cached = false;
+    if (not linked()) return;
+
+    GLint count = 0;
+    glGetProgramInterfaceiv(native_handle(), GL_UNIFORM, GL_ACTIVE_RESOURCES,
+                            &count);
+    GLint max_length = 0;
+    glGetProgramInterfaceiv(native_handle(), GL_UNIFORM, GL_MAX_NAME_LENGTH,
+                            &max_length);
+    std::string buffer(max_length, '\0');
+    for (GLint i = 0; i < count; ++i) {
+      // Members of uniform blocks do not have a location.
+      const GLenum property = GL_LOCATION;
+      GLint location = -1;
+      glGetProgramResourceiv(native_handle(), GL_UNIFORM, i, 1, &property, 1,
+                             nullptr, &location);
+      if (location == -1) continue;
+
+      GLsizei length = 0;
+      glGetProgramResourceName(native_handle(), GL_UNIFORM, i, buffer.size(),
+                               &length, buffer.data());
+      std::string_view name{buffer.data(), static_cast<size_t>(length)};
+      uniform_locations.emplace_back(uniform_hash(name), location);
+      // Arrays are reported as 'name[0]' but may be addressed by 'name'.
+      if (name.ends_with("[0]")) {
+        name.remove_suffix(3);
+        uniform_locations.emplace_back(uniform_hash(name), location);
+      }
+    }
+
+    std::ranges::sort(uniform_locations);
+    size_t k = 0;
+    for (size_t i = 0; i < uniform_locations.size();) {
+      auto j = i + 1;
+      while ((j < uniform_locations.size()) &&
+             (uniform_locations[j].first == uniform_locations[i].first))
+        ++j;
+      uniform_locations[k] = uniform_locations[i];
+      if (j - i > 1) uniform_locations[k].second = colliding_location;
+      ++k;
+      i = j;
+    }
+    uniform_locations.resize(k);
+    uniform_locations_cached = true;
+  }
+
+  auto uniform_location(uniform_identifier id) const noexcept -> GLint {
+    if (not uniform_locations_cached)
+      return glGetUniformLocation(native_handle(), id.name);
+    const auto it = std::ranges::lower_bound(
+        uniform_locations, id.hash, {}, &std::pair<uint64, GLint>::first);
+    // Unknown names do not refer to active uniforms.
+    if ((it == uniform_locations.end()) or (it->first != id.hash)) return -1;
+    if (it->second == colliding_location)
+      return glGetUniformLocation(native_handle(), id.name);
+    return it->second;
   }
 
-  auto valid_uniform_location(czstring name) {
-    const auto result = uniform_location(name);
-    if (result == -1) throw invalid_uniform_identifier{name};
+  auto valid_uniform_location(uniform_identifier id) const {
+    const auto result = uniform_location(id);
+    if (result == -1) throw invalid_uniform_identifier{id.name};
     return result;
   }
 
  public:
-  void set(czstring name, auto&& value) {
-    try_set(valid_uniform_location(name), std::forward<decltype(value)>(value));
+  void set(uniform_identifier id, auto&& value) {
+    try_set(valid_uniform_location(id), std::forward<decltype(value)>(value));
   }
 
-  void try_set(czstring name, auto&& value) noexcept {
-    try_set(uniform_location(name), std::forward<decltype(value)>(value));
+  void try_set(uniform_identifier id, auto&& value) noexcept {
+    try_set(uniform_location(id), std::forward<decltype(value)>(value));
   }
 
  private:
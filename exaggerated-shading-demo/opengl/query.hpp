@@ -0,0 +1,71 @@
+#pragma once
+#include "defaults.hpp"
+
+namespace demo::opengl {
+
+///
+///
+struct query_base : object {
+  /// Base Type and Constructors
+  ///
+  using base = object;
+  using base::base;
+
+  /// Obtains a valid OpenGL query handle for the given target,
+  /// such as 'GL_TIME_ELAPSED'. If acquiring the handle fails,
+  /// it throws a 'resource_acquisition_error'.
+  ///
+  static auto create(GLenum target) -> query_base {
+    native_handle_type handle;
+    glCreateQueries(target, 1, &handle);
+    return query_base{handle};
+  }
+
+  /// Deleting an active query ends it implicitly.
+  ///
+  static void destroy(query_base& resource) noexcept {
+    // Silently ignores zero and names that do
+    // not correspond to existing query objects.
+    glDeleteQueries(1, &resource.handle);
+  }
+
+  ///
+  ///
+  bool valid() const noexcept { return glIsQuery(handle) == GL_TRUE; }
+
+  /// Start the query on the given target. Only one query per target
+  /// can be active at a time and it is stopped by 'end'.
+  ///
+  void begin(GLenum target) const noexcept {
+    glBeginQuery(target, native_handle());
+  }
+
+  static void end(GLenum target) noexcept { glEndQuery(target); }
+
+  /// Whether the result can be read without waiting for the GPU.
+  ///
+  bool available() const noexcept {
+    GLint result = 0;
+    glGetQueryObjectiv(native_handle(), GL_QUERY_RESULT_AVAILABLE, &result);
+    return result != 0;
+  }
+
+  /// The result of the query, such as elapsed nanoseconds.
+  /// Blocks until the result is available.
+  ///
+  auto result() const noexcept -> uint64 {
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(native_handle(), GL_QUERY_RESULT, &value);
+    return value;
+  }
+};
+
+///
+///
+STRICT_FINAL_USING(query, unique<query_base>);
+
+///
+///
+STRICT_FINAL_USING(query_view, view<query>);
+
+}  // namespace demo::opengl
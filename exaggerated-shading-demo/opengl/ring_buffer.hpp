@@ -0,0 +1,129 @@
+#pragma once
+#include <span>
+//
+#include "buffer.hpp"
+
+namespace demo::opengl {
+
+/// Persistently mapped buffer that is split into regions
+/// which are written by the CPU in round-robin order.
+/// While the GPU reads one region, the next one can already be filled.
+/// Fences make sure that a region is only reused
+/// after all commands reading from it have been finished.
+/// No reallocation and no implicit synchronization is involved.
+///
+/// Typical usage per update:
+///   1. 'acquire' the next region and fill its elements,
+///   2. issue the commands that read from it at 'offset',
+///   3. 'release' the region after the last of these commands.
+///
+template <transferable type>
+struct ring_buffer {
+  using value_type = type;
+
+  /// The default constructor does not allocate any storage.
+  ///
+  ring_buffer() = default;
+
+  /// Allocate 'regions' regions of 'count' elements each.
+  /// Every region starts at a multiple of 'alignment' bytes, such as
+  /// 'GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT' for uniform blocks.
+  ///
+  explicit ring_buffer(size_type count,
+                       size_type regions = 3,
+                       size_type alignment = alignof(value_type))
+      : elements{count},
+        stride{(count * size_type(sizeof(value_type)) + alignment - 1) /
+               alignment * alignment},
+        fences(regions, nullptr) {
+    const auto size = stride * regions;
+    constexpr auto flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    data.allocate_storage(size, flags);
+    mapping = static_cast<std::byte*>(data.map(0, size, flags));
+    if (not mapping)
+      throw resource_acquisition_error{"Failed to map OpenGL ring buffer."};
+  }
+
+  /// Deleting the buffer implicitly releases the persistent mapping.
+  ///
+  ~ring_buffer() noexcept {
+    for (auto fence : fences)
+      if (fence) glDeleteSync(fence);
+  }
+
+  ring_buffer(const ring_buffer&) = delete;
+  ring_buffer& operator=(const ring_buffer&) = delete;
+
+  ring_buffer(ring_buffer&& other) noexcept { swap(other); }
+  ring_buffer& operator=(ring_buffer&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  void swap(ring_buffer& other) noexcept {
+    using std::swap;
+    swap(data, other.data);
+    swap(mapping, other.mapping);
+    swap(elements, other.elements);
+    swap(stride, other.stride);
+    swap(fences, other.fences);
+    swap(current, other.current);
+  }
+
+  auto buffer() const noexcept -> buffer_view { return data; }
+
+  /// Number of elements per region
+  ///
+  auto size() const noexcept -> size_type { return elements; }
+
+  auto empty() const noexcept -> bool { return elements == 0; }
+
+  /// Byte offset of the current region in the buffer
+  ///
+  auto offset() const noexcept -> offset_type { return current * stride; }
+
+  /// Advance to the next region and wait until the GPU is done with it.
+  /// The returned elements may be written until the region is released.
+  /// Default-constructed ring buffers have no regions and return nothing.
+  ///
+  auto acquire() noexcept -> std::span<value_type> {
+    if (fences.empty()) return {};
+    current = (current + 1) % fences.size();
+    auto& fence = fences[current];
+    if (fence) {
+      // Flush only once such that the fence is guaranteed to be signaled.
+      SyncObjectMask flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+      while (true) {
+        const auto status = glClientWaitSync(fence, flags, 1'000'000);
+        if ((status == GL_ALREADY_SIGNALED) ||
+            (status == GL_CONDITION_SATISFIED) || (status == GL_WAIT_FAILED))
+          break;
+        flags = SyncObjectMask::GL_NONE_BIT;
+      }
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+    return {reinterpret_cast<value_type*>(mapping + offset()), elements};
+  }
+
+  /// Mark the current region as used by all previously issued commands.
+  /// Call it again after every further command reading from the region.
+  ///
+  void release() noexcept {
+    if (fences.empty()) return;
+    auto& fence = fences[current];
+    if (fence) glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, UnusedMask::GL_NONE_BIT);
+  }
+
+ private:
+  struct buffer data {};
+  std::byte* mapping = nullptr;
+  size_type elements = 0;
+  size_type stride = 0;
+  std::vector<GLsync> fences{};
+  size_type current = 0;
+};
+
+}  // namespace demo::opengl
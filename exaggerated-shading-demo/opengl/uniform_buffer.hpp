@@ -0,0 +1,42 @@
+#pragma once
+#include "buffer.hpp"
+
+namespace demo::opengl {
+
+/// Types that can be copied byte by byte into a uniform block
+/// with 'std140' layout. Members must be laid out as in the shader.
+/// Scalars, 'vec2', 'vec4', and 'mat4' members already match when
+/// they are ordered by decreasing alignment. 'vec3' needs to be padded.
+///
+template <typename type>
+concept std140_layout = std::is_trivially_copyable_v<type> &&
+                        std::is_standard_layout_v<type> &&
+                        (sizeof(type) % sizeof(vec4) == 0);
+
+/// Buffer for a single uniform block of the given type.
+/// Its data store is immutable and the whole block
+/// is updated by a single call without reallocation.
+///
+template <std140_layout type>
+struct uniform_buffer {
+  using value_type = type;
+
+  uniform_buffer() { data.allocate_storage(sizeof(value_type)); }
+
+  explicit uniform_buffer(const value_type& value) : uniform_buffer{} {
+    write(value);
+  }
+
+  auto buffer() const noexcept -> buffer_view { return data; }
+
+  void bind_base(uint index) const noexcept {
+    data.bind_base(GL_UNIFORM_BUFFER, index);
+  }
+
+  void write(const value_type& value) const noexcept { data.write(&value, 1); }
+
+ protected:
+  struct buffer data;
+};
+
+}  // namespace demo::opengl
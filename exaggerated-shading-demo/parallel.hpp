@@ -0,0 +1,99 @@
+#pragma once
+#include <exception>
+#include <thread>
+//
+#include "defaults.hpp"
+
+namespace demo {
+
+/// Number of worker threads used by the parallel algorithms.
+/// Falls back to one thread if the hardware concurrency is unknown.
+///
+inline auto thread_count() noexcept -> size_t {
+  return std::max(size_t{1}, size_t{thread::hardware_concurrency()});
+}
+
+/// Call 'f(chunk)' for every chunk index in [0, chunks) on its own thread.
+/// The calling thread processes the first chunk itself.
+/// If chunks throw, the exception of the smallest chunk index is rethrown
+/// after all threads have been joined.
+///
+template <typename function>
+void parallel_for_chunks(size_t chunks, function&& f) {
+  if (chunks == 0) return;
+  if (chunks == 1) {
+    f(size_t{0});
+    return;
+  }
+  vector<exception_ptr> errors(chunks);
+  {
+    vector<jthread> threads{};
+    threads.reserve(chunks - 1);
+    for (size_t i = 1; i < chunks; ++i)
+      threads.emplace_back([&f, &errors, i] {
+        try {
+          f(i);
+        } catch (...) {
+          errors[i] = current_exception();
+        }
+      });
+    try {
+      f(size_t{0});
+    } catch (...) {
+      errors[0] = current_exception();
+    }
+  }
+  for (const auto& e : errors)
+    if (e) rethrow_exception(e);
+}
+
+inline constexpr size_t default_grain = size_t{1} << 14;
+
+/// Number of chunks that 'n' elements are split into, such that
+/// every chunk has at least 'grain' elements and no thread is idle.
+///
+inline auto chunk_count(size_t n, size_t grain = default_grain) noexcept
+    -> size_t {
+  return std::clamp(n / std::max(grain, size_t{1}), size_t{1}, thread_count());
+}
+
+/// Start of chunk 'i' when 'n' elements are split into 'chunks' chunks.
+///
+constexpr auto chunk_begin(size_t i, size_t n, size_t chunks) noexcept
+    -> size_t {
+  return i * n / chunks;
+}
+
+/// Split the index range [0, n) into at most 'thread_count()' contiguous
+/// chunks of at least 'grain' elements and call 'f(first, last)' for each.
+///
+template <typename function>
+void parallel_for(size_t n, function&& f, size_t grain = default_grain) {
+  const auto chunks = chunk_count(n, grain);
+  parallel_for_chunks(chunks, [&](size_t i) {
+    f(chunk_begin(i, n, chunks), chunk_begin(i + 1, n, chunks));
+  });
+}
+
+/// Sort chunks of the range in parallel and merge them pairwise afterwards.
+/// For a strict total order, the result does not depend on the thread count.
+///
+template <random_access_iterator iterator, typename compare = std::less<>>
+void parallel_sort(iterator first, iterator last, compare comp = {}) {
+  const size_t n = last - first;
+  const auto chunks = chunk_count(n);
+  const auto at = [&](size_t i) {
+    return first + chunk_begin(std::min(i, chunks), n, chunks);
+  };
+  parallel_for_chunks(chunks,
+                      [&](size_t i) { std::sort(at(i), at(i + 1), comp); });
+  for (size_t width = 1; width < chunks; width *= 2) {
+    const auto merges = (chunks + 2 * width - 1) / (2 * width);
+    parallel_for_chunks(merges, [&](size_t i) {
+      const auto a = 2 * i * width;
+      std::inplace_merge(at(a), at(a + width), at(a + 2 * width), comp);
+    });
+  }
+}
+
+}  // namespace demo
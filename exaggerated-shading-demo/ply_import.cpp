@@ -0,0 +1,432 @@
+#include "ply_import.hpp"
+//
+#include <charconv>
+
+namespace demo {
+
+namespace {
+
+enum class ply_type : uint8 {
+  int8,
+  uint8,
+  int16,
+  uint16,
+  int32,
+  uint32,
+  float32,
+  float64,
+};
+
+auto ply_type_from(string_view name) -> ply_type {
+  constexpr pair<string_view, ply_type> names[] = {
+      {"char", ply_type::int8},       {"int8", ply_type::int8},
+      {"uchar", ply_type::uint8},     {"uint8", ply_type::uint8},
+      {"short", ply_type::int16},     {"int16", ply_type::int16},
+      {"ushort", ply_type::uint16},   {"uint16", ply_type::uint16},
+      {"int", ply_type::int32},       {"int32", ply_type::int32},
+      {"uint", ply_type::uint32},     {"uint32", ply_type::uint32},
+      {"float", ply_type::float32},   {"float32", ply_type::float32},
+      {"double", ply_type::float64},  {"float64", ply_type::float64},
+  };
+  for (const auto& [str, type] : names)
+    if (name == str) return type;
+  throw runtime_error(
+      format("Failed to parse property type '{}' in PLY header.", name));
+}
+
+constexpr auto size_of(ply_type type) noexcept -> size_t {
+  switch (type) {
+    case ply_type::int8:
+    case ply_type::uint8:
+      return 1;
+    case ply_type::int16:
+    case ply_type::uint16:
+      return 2;
+    case ply_type::float64:
+      return 8;
+    default:
+      return 4;
+  }
+}
+
+/// Read an unaligned value of the given type and convert it.
+/// PLY data is read in place. So, values have no alignment.
+///
+template <typename result>
+auto read_as(const char* data, ply_type type) noexcept -> result {
+  const auto load = [data](auto value) {
+    memcpy(&value, data, sizeof(value));
+    return static_cast<result>(value);
+  };
+  switch (type) {
+    case ply_type::int8:
+      return load(int8_t{});
+    case ply_type::uint8:
+      return load(uint8{});
+    case ply_type::int16:
+      return load(int16_t{});
+    case ply_type::uint16:
+      return load(uint16{});
+    case ply_type::int32:
+      return load(int32_t{});
+    case ply_type::uint32:
+      return load(uint32{});
+    case ply_type::float32:
+      return load(float32{});
+    default:
+      return load(float64{});
+  }
+}
+
+struct ply_property {
+  string_view name;
+  ply_type type;
+  // Lists store their number of values in front of them.
+  bool list = false;
+  ply_type count_type{};
+};
+
+struct ply_element {
+  string_view name;
+  size_t count{};
+  vector<ply_property> properties{};
+
+  /// Size of every record in bytes if there are no list properties.
+  ///
+  auto stride() const noexcept -> optional<size_t> {
+    size_t result = 0;
+    for (const auto& p : properties) {
+      if (p.list) return nullopt;
+      result += size_of(p.type);
+    }
+    return result;
+  }
+
+  /// Offset and type of the scalar property with the given name.
+  /// Only meaningful if there are no list properties.
+  ///
+  auto find(string_view name) const noexcept
+      -> optional<pair<size_t, ply_type>> {
+    size_t offset = 0;
+    for (const auto& p : properties) {
+      if (p.name == name) return pair{offset, p.type};
+      offset += size_of(p.type);
+    }
+    return nullopt;
+  }
+};
+
+struct ply_header {
+  bool binary_little_endian = false;
+  vector<ply_element> elements{};
+  // Size in bytes including the line of 'end_header'
+  size_t size{};
+};
+
+auto ply_header_from(string_view content) -> ply_header {
+  ply_header header{};
+  bool first = true;
+  for (size_t pos = 0; pos < content.size();) {
+    const auto line_end = std::min(content.find('\n', pos), content.size());
+    auto line = content.substr(pos, line_end - pos);
+    pos = line_end + 1;
+    if (line.ends_with('\r')) line.remove_suffix(1);
+
+    // Header lines are short. So, allocating their tokens is fine.
+    vector<string_view> tokens{};
+    for (size_t i = 0; i < line.size();) {
+      const auto j = std::min(line.find(' ', i), line.size());
+      if (j > i) tokens.push_back(line.substr(i, j - i));
+      i = j + 1;
+    }
+
+    if (first) {
+      if ((tokens.size() != 1) || (tokens[0] != "ply"))
+        throw runtime_error{"Failed to match keyword 'ply' at the start."};
+      first = false;
+    } else if (tokens.empty() || (tokens[0] == "comment") ||
+               (tokens[0] == "obj_info"))
+      continue;
+    else if ((tokens[0] == "format") && (tokens.size() == 3))
+      header.binary_little_endian = (tokens[1] == "binary_little_endian");
+    else if ((tokens[0] == "element") && (tokens.size() == 3)) {
+      auto& element = header.elements.emplace_back(tokens[1]);
+      const auto& str = tokens[2];
+      const auto [ptr, error] =
+          from_chars(str.data(), str.data() + str.size(), element.count);
+      if ((error != errc{}) || (ptr != str.data() + str.size()))
+        throw runtime_error(format(
+            "Failed to parse count of element '{}' in PLY header.", tokens[1]));
+    } else if ((tokens[0] == "property") && !header.elements.empty()) {
+      auto& properties = header.elements.back().properties;
+      if ((tokens.size() == 5) && (tokens[1] == "list"))
+        properties.push_back({.name = tokens[4],
+                              .type = ply_type_from(tokens[3]),
+                              .list = true,
+                              .count_type = ply_type_from(tokens[2])});
+      else if (tokens.size() == 3)
+        properties.push_back(
+            {.name = tokens[2], .type = ply_type_from(tokens[1])});
+      else
+        throw runtime_error(
+            format("Failed to parse property '{}' in PLY header.", line));
+    } else if (tokens[0] == "end_header") {
+      header.size = std::min(pos, content.size());
+      return header;
+    } else
+      throw runtime_error(
+          format("Failed to parse line '{}' in PLY header.", line));
+  }
+  throw runtime_error{"Failed to match keyword 'end_header' in PLY file."};
+}
+
+auto truncation_error(const ply_element& element) -> runtime_error {
+  return runtime_error(format(
+      "Failed to read element '{}' of PLY file. The file is truncated.",
+      element.name));
+}
+
+/// Skip all records of an element and return the start of the next one.
+/// Elements with list properties have to be traversed record by record.
+///
+auto skip(const ply_element& element, const char* data, const char* end)
+    -> const char* {
+  if (const auto stride = element.stride()) {
+    if (size_t(end - data) < element.count * *stride)
+      throw truncation_error(element);
+    return data + element.count * *stride;
+  }
+  for (size_t i = 0; i < element.count; ++i) {
+    for (const auto& p : element.properties) {
+      size_t size = size_of(p.type);
+      if (p.list) {
+        if (size_t(end - data) < size_of(p.count_type))
+          throw truncation_error(element);
+        size *= read_as<size_t>(data, p.count_type);
+        data += size_of(p.count_type);
+      }
+      if (size_t(end - data) < size) throw truncation_error(element);
+      data += size;
+    }
+  }
+  return data;
+}
+
+/// Read all vertex records in parallel straight into the scene.
+/// Normals stay zero if the vertices do not provide them.
+///
+void read_vertices(const ply_element& element,
+                   const char* data,
+                   const char* end,
+                   scene& s) {
+  const auto stride = element.stride();
+  if (!stride)
+    throw runtime_error{"Failed to read vertices with list properties."};
+  if (element.count >= scene::invalid)
+    throw runtime_error(
+        format("Failed to index {} vertices of PLY file with 32 bits.",
+               element.count));
+  if (size_t(end - data) < element.count * *stride)
+    throw truncation_error(element);
+
+  const auto x = element.find("x");
+  const auto y = element.find("y");
+  const auto z = element.find("z");
+  if (!x || !y || !z)
+    throw runtime_error{"Failed to find vertex positions in PLY file."};
+  const auto nx = element.find("nx");
+  const auto ny = element.find("ny");
+  const auto nz = element.find("nz");
+  const auto has_normals = nx && ny && nz;
+
+  s.vertices.resize(element.count);
+  parallel_for(element.count, [&](size_t first, size_t last) {
+    for (auto i = first; i < last; ++i) {
+      const auto record = data + i * *stride;
+      const auto get = [record](const pair<size_t, ply_type>& p) {
+        return read_as<float32>(record + p.first, p.second);
+      };
+      auto& v = s.vertices[i];
+      v.position = {get(*x), get(*y), get(*z)};
+      if (has_normals) v.normal = {get(*nx), get(*ny), get(*nz)};
+    }
+  });
+}
+
+/// Read all face records straight into the scene and return
+/// the start of the next element. Polygons are triangulated as fans.
+///
+auto read_faces(const ply_element& element,
+                const char* data,
+                const char* end,
+                scene& s) -> const char* {
+  const auto list = std::ranges::find_if(element.properties, [](auto& p) {
+    return p.list &&
+           ((p.name == "vertex_indices") || (p.name == "vertex_index"));
+  });
+  if (list == element.properties.end())
+    throw runtime_error{"Failed to find vertex indices of faces in PLY file."};
+  const auto vertex_count = s.vertices.size();
+  const auto index_size = size_of(list->type);
+  const auto count_size = size_of(list->count_type);
+
+  // Position of the indices and the number of corners of the face
+  // in the record at 'data' together with the start of the next record.
+  //
+  struct face_record {
+    const char* indices;
+    size_t corners;
+    const char* next;
+  };
+  const auto read_record = [&](const char* record) {
+    face_record result{};
+    for (const auto& p : element.properties) {
+      size_t size = size_of(p.type);
+      if (p.list) {
+        if (size_t(end - record) < size_of(p.count_type))
+          throw truncation_error(element);
+        const auto count = read_as<size_t>(record, p.count_type);
+        record += size_of(p.count_type);
+        size *= count;
+        if (&p == &*list) result = {.indices = record, .corners = count};
+      }
+      if (size_t(end - record) < size) throw truncation_error(element);
+      record += size;
+    }
+    result.next = record;
+    return result;
+  };
+  const auto index = [&](const char* indices, size_t k) {
+    const auto i = read_as<int64_t>(indices + k * index_size, list->type);
+    if ((i < 0) || (i >= int64_t(vertex_count)))
+      throw runtime_error(format(
+          "Failed to resolve vertex index {} in PLY file with {} vertices.", i,
+          vertex_count));
+    return scene::vertex_index(i);
+  };
+
+  const auto chunks = chunk_count(element.count);
+
+  // Scanners mostly write triangles only. Then all records have the same
+  // size and faces are read in parallel without looking at them first.
+  // The assumption holds if every record of the indices is a triangle.
+  // Otherwise, the records are misaligned and all faces are read again.
+  //
+  const auto lists = std::ranges::count_if(element.properties,
+                                           [](auto& p) { return p.list; });
+  if (lists == 1) {
+    size_t offset = 0;
+    for (auto it = element.properties.begin(); it != list; ++it)
+      offset += size_of(it->type);
+    size_t stride = count_size + 3 * index_size;
+    for (const auto& p : element.properties)
+      if (!p.list) stride += size_of(p.type);
+
+    if (size_t(end - data) >= element.count * stride) {
+      s.faces.resize(element.count);
+      vector<uint8> valid(chunks, true);
+      parallel_for_chunks(chunks, [&](size_t c) {
+        const auto first = chunk_begin(c, element.count, chunks);
+        const auto last = chunk_begin(c + 1, element.count, chunks);
+        for (auto i = first; i < last; ++i) {
+          const auto record = data + i * stride + offset;
+          if (read_as<size_t>(record, list->count_type) != 3) {
+            valid[c] = false;
+            return;
+          }
+          for (int k = 0; k < 3; ++k) {
+            const auto v = read_as<int64_t>(
+                record + count_size + k * index_size, list->type);
+            // Misaligned records may produce invalid indices.
+            // Errors are only reported by the general path.
+            if ((v < 0) || (v >= int64_t(vertex_count))) {
+              valid[c] = false;
+              return;
+            }
+            s.faces[i][k] = scene::vertex_index(v);
+          }
+        }
+      });
+      if (std::ranges::all_of(valid, [](auto x) { return x; }))
+        return data + element.count * stride;
+    }
+  }
+
+  // In general, a serial pass finds the start of every chunk
+  // and the number of triangles before it. Afterwards,
+  // chunks are triangulated in parallel straight into the scene.
+  //
+  vector<const char*> starts(chunks + 1);
+  vector<size_t> offsets(chunks + 1);
+  auto record = data;
+  size_t triangles = 0;
+  for (size_t c = 0; c < chunks; ++c) {
+    starts[c] = record;
+    offsets[c] = triangles;
+    const auto first = chunk_begin(c, element.count, chunks);
+    const auto last = chunk_begin(c + 1, element.count, chunks);
+    for (auto i = first; i < last; ++i) {
+      const auto face = read_record(record);
+      if (face.corners < 3)
+        throw runtime_error{
+            "Failed to read face with less than three vertices in PLY file."};
+      triangles += face.corners - 2;
+      record = face.next;
+    }
+  }
+  starts[chunks] = record;
+  offsets[chunks] = triangles;
+  if (triangles >= scene::invalid)
+    throw runtime_error(format(
+        "Failed to index {} faces of PLY file with 32 bits.", triangles));
+
+  s.faces.resize(triangles);
+  parallel_for_chunks(chunks, [&](size_t c) {
+    auto record = starts[c];
+    auto fid = offsets[c];
+    while (record != starts[c + 1]) {
+      const auto face = read_record(record);
+      const auto first = index(face.indices, 0);
+      auto previous = index(face.indices, 1);
+      for (size_t k = 2; k < face.corners; ++k) {
+        const auto current = index(face.indices, k);
+        s.faces[fid++] = {first, previous, current};
+        previous = current;
+      }
+      record = face.next;
+    }
+  });
+  return record;
+}
+
+}  // namespace
+
+auto scene_from_ply_data(string_view content) -> optional<scene> {
+  DEMO_TRACE_SCOPE("scene_from_ply_data");
+  const auto header = ply_header_from(content);
+  if (!header.binary_little_endian) return nullopt;
+  // Records are read in place by copying their bytes.
+  static_assert(endian::native == endian::little);
+
+  struct scene scene{};
+  auto data = content.data() + header.size;
+  const auto end = content.data() + content.size();
+  for (const auto& element : header.elements) {
+    if (element.name == "vertex") {
+      read_vertices(element, data, end, scene);
+      data += element.count * *element.stride();
+    } else if (element.name == "face")
+      data = read_faces(element, data, end, scene);
+    else
+      data = skip(element, data, end);
+  }
+
+  // Faces that collapse to a line or a point have no normal
+  // and would introduce loops into the adjacency.
+  erase_if(scene.faces, [](const auto& f) {
+    return (f[0] == f[1]) || (f[1] == f[2]) || (f[2] == f[0]);
+  });
+  return scene;
+}
+
+}  // namespace demo
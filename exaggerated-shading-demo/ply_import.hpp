@@ -0,0 +1,17 @@
+#pragma once
+#include "scene.hpp"
+
+namespace demo {
+
+/// Parse the raw content of a binary little-endian PLY file that has
+/// already been read or memory-mapped directly into a scene.
+/// Vertices need the scalar properties 'x', 'y', and 'z'. The normals
+/// 'nx', 'ny', and 'nz' are used if they are given and left zero
+/// otherwise. Faces are read from the list property
+/// 'vertex_indices' or 'vertex_index' and triangulated as fans.
+/// Other elements and properties are skipped.
+/// ASCII-based and big-endian files are not handled and return nothing.
+///
+auto scene_from_ply_data(string_view content) -> optional<scene>;
+
+}  // namespace demo
@@ -0,0 +1,292 @@
+#pragma once
+#include "scene.hpp"
+
+namespace demo {
+
+/// Methods to reorder vertices and faces of a scene for cache locality.
+/// Neighbor gathers in 'smooth_normals' profit from nearby vertices
+/// having nearby indices. The GPU profits from consecutive faces
+/// sharing vertices in its post-transform vertex cache.
+///
+enum class reordering : uint32 {
+  none = 0,
+  morton = 1,   // vertices along a Z-order curve over their positions
+  rcm = 2,      // vertices by reverse Cuthill-McKee over the adjacency
+  tipsify = 3,  // faces by Tipsify, vertices by their first use
+};
+
+constexpr auto reordering_string(reordering method) noexcept -> czstring {
+  switch (method) {
+    case reordering::morton:
+      return "morton";
+    case reordering::rcm:
+      return "rcm";
+    case reordering::tipsify:
+      return "tipsify";
+    default:
+      return "none";
+  }
+}
+
+inline auto reordering_from(string_view str) -> reordering {
+  for (auto method : {reordering::none, reordering::morton, reordering::rcm,
+                      reordering::tipsify})
+    if (str == reordering_string(method)) return method;
+  throw runtime_error(format("Failed to parse reordering method '{}'.", str));
+}
+
+/// Average cache miss ratio (ACMR) of drawing the faces in their order
+/// through a FIFO post-transform vertex cache with 'cache_size' entries.
+/// It is the number of transformed vertices per face and lies in [0.5, 3]
+/// for large closed meshes.
+///
+inline auto average_cache_miss_ratio(const scene& s, uint32 cache_size = 16)
+    -> float64 {
+  if (s.faces.empty()) return 0;
+  // A vertex is still cached if less than 'cache_size'
+  // misses have happened since it has been inserted.
+  vector<size_t> inserted(s.vertices.size(), numeric_limits<size_t>::max());
+  size_t misses = 0;
+  for (const auto& f : s.faces) {
+    for (const auto v : f) {
+      if ((inserted[v] != numeric_limits<size_t>::max()) &&
+          (misses - inserted[v] < cache_size))
+        continue;
+      inserted[v] = misses++;
+    }
+  }
+  return float64(misses) / s.faces.size();
+}
+
+namespace detail {
+
+/// Spread the lower 21 bits of 'x' to every third bit.
+///
+constexpr auto morton_spread(uint64_t x) noexcept -> uint64_t {
+  x &= 0x1fffff;
+  x = (x | x << 32) & 0x1f00000000ffff;
+  x = (x | x << 16) & 0x1f0000ff0000ff;
+  x = (x | x << 8) & 0x100f00f00f00f00f;
+  x = (x | x << 4) & 0x10c30c30c30c30c3;
+  x = (x | x << 2) & 0x1249249249249249;
+  return x;
+}
+
+}  // namespace detail
+
+/// Vertex order along the Z-order curve of their positions
+/// quantized to 21 bits per axis inside the bounding box.
+///
+inline auto morton_order(const scene& s) -> vector<scene::vertex_index> {
+  const auto box = aabb_from(s);
+  const auto extent = box._max - box._min;
+  const auto scale = real((1 << 21) - 1) /
+                     std::max({extent.x, extent.y, extent.z, real(1e-30)});
+  vector<pair<uint64_t, scene::vertex_index>> keys(s.vertices.size());
+  parallel_for(keys.size(), [&](size_t first, size_t last) {
+    for (auto i = first; i < last; ++i) {
+      const auto q = (s.vertices[i].position - box._min) * scale;
+      keys[i] = {detail::morton_spread(uint64_t(q.x)) |
+                     detail::morton_spread(uint64_t(q.y)) << 1 |
+                     detail::morton_spread(uint64_t(q.z)) << 2,
+                 scene::vertex_index(i)};
+    }
+  });
+  parallel_sort(keys.begin(), keys.end());
+  vector<scene::vertex_index> result(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) result[i] = keys[i].second;
+  return result;
+}
+
+/// Vertex order by reverse Cuthill-McKee that reduces the bandwidth
+/// of the adjacency matrix. Every connected component is traversed
+/// breadth-first from a vertex of minimal degree and neighbors are
+/// enqueued by increasing degree. Needs the CSR adjacency of the scene.
+///
+inline auto reverse_cuthill_mckee_order(const scene& s)
+    -> vector<scene::vertex_index> {
+  const auto n = s.vertices.size();
+  assert(s.neighbor_offsets.size() == n + 1);
+  const auto degree = [&](scene::vertex_index v) {
+    return s.neighbor_offsets[v + 1] - s.neighbor_offsets[v];
+  };
+
+  // Start vertices are taken by increasing degree.
+  vector<scene::vertex_index> starts(n);
+  for (size_t i = 0; i < n; ++i) starts[i] = i;
+  parallel_sort(starts.begin(), starts.end(), [&](auto u, auto v) {
+    return pair{degree(u), u} < pair{degree(v), v};
+  });
+
+  vector<scene::vertex_index> result{};
+  result.reserve(n);
+  vector<bool> visited(n);
+  vector<scene::vertex_index> candidates{};
+  for (const auto start : starts) {
+    if (visited[start]) continue;
+    visited[start] = true;
+    // The result itself serves as queue of the breadth-first search.
+    result.push_back(start);
+    for (auto head = result.size() - 1; head < result.size(); ++head) {
+      const auto v = result[head];
+      candidates.clear();
+      for (auto k = s.neighbor_offsets[v]; k < s.neighbor_offsets[v + 1]; ++k)
+        if (const auto u = s.neighbors[k]; !visited[u]) {
+          visited[u] = true;
+          candidates.push_back(u);
+        }
+      std::ranges::sort(candidates, [&](auto u, auto w) {
+        return pair{degree(u), u} < pair{degree(w), w};
+      });
+      result.insert(result.end(), candidates.begin(), candidates.end());
+    }
+  }
+  std::ranges::reverse(result);
+  return result;
+}
+
+/// Face order by the Tipsify algorithm of Sander, Nehab, and Barczak.
+/// Faces are emitted in fans around a current vertex. The next vertex
+/// is a neighbor that is still in the simulated cache and has faces left.
+/// At dead ends, recently used vertices and then the first vertex
+/// with remaining faces are taken.
+///
+inline auto tipsify_order(const scene& s, uint32 cache_size = 16)
+    -> vector<scene::face_index> {
+  const auto n = s.vertices.size();
+  const auto m = s.faces.size();
+
+  // The remaining faces per vertex start at its valence.
+  const auto [offsets, adjacent_faces] = s.vertex_faces();
+  vector<uint32> live(n);
+  for (size_t v = 0; v < n; ++v) live[v] = offsets[v + 1] - offsets[v];
+
+  vector<scene::face_index> result{};
+  result.reserve(m);
+  vector<bool> emitted(m);
+  // Time stamps of the vertices in the simulated cache
+  vector<size_t> cached(n);
+  size_t time = cache_size + 1;
+  vector<scene::vertex_index> dead_ends{};
+  vector<scene::vertex_index> candidates{};
+  size_t cursor = 0;
+
+  const auto skip_dead_end = [&]() -> scene::vertex_index {
+    while (!dead_ends.empty()) {
+      const auto v = dead_ends.back();
+      dead_ends.pop_back();
+      if (live[v] > 0) return v;
+    }
+    for (; cursor < n; ++cursor)
+      if (live[cursor] > 0) return cursor;
+    return scene::invalid;
+  };
+
+  const auto next_vertex = [&]() -> scene::vertex_index {
+    auto best = scene::invalid;
+    size_t priority = 0;
+    for (const auto v : candidates) {
+      if (live[v] == 0) continue;
+      // Prefer the oldest vertex that stays in the cache
+      // after emitting all of its remaining faces.
+      size_t p = 0;
+      if (time - cached[v] + 2 * live[v] <= cache_size) p = time - cached[v];
+      if ((best == scene::invalid) || (p > priority)) {
+        best = v;
+        priority = p;
+      }
+    }
+    return (best == scene::invalid) ? skip_dead_end() : best;
+  };
+
+  for (auto v = skip_dead_end(); v != scene::invalid; v = next_vertex()) {
+    candidates.clear();
+    for (auto k = offsets[v]; k < offsets[v + 1]; ++k) {
+      const auto f = adjacent_faces[k];
+      if (emitted[f]) continue;
+      emitted[f] = true;
+      result.push_back(f);
+      for (const auto u : s.faces[f]) {
+        dead_ends.push_back(u);
+        candidates.push_back(u);
+        --live[u];
+        if (time - cached[u] > cache_size) cached[u] = time++;
+      }
+    }
+  }
+  return result;
+}
+
+/// Vertex order by the first use of vertices in the face order.
+/// Unreferenced vertices are moved to the end.
+///
+inline auto first_use_order(const scene& s) -> vector<scene::vertex_index> {
+  vector<scene::vertex_index> result{};
+  result.reserve(s.vertices.size());
+  vector<bool> used(s.vertices.size());
+  for (const auto& f : s.faces)
+    for (const auto v : f)
+      if (!used[v]) {
+        used[v] = true;
+        result.push_back(v);
+      }
+  for (size_t v = 0; v < s.vertices.size(); ++v)
+    if (!used[v]) result.push_back(v);
+  return result;
+}
+
+/// Face order by the smallest index of their vertices.
+/// After reordering the vertices, faces then follow the same locality.
+///
+inline auto face_order_by_vertices(const scene& s)
+    -> vector<scene::face_index> {
+  vector<pair<scene::vertex_index, scene::face_index>> keys(s.faces.size());
+  parallel_for(keys.size(), [&](size_t first, size_t last) {
+    for (auto i = first; i < last; ++i)
+      keys[i] = {std::ranges::min(s.faces[i]), scene::face_index(i)};
+  });
+  parallel_sort(keys.begin(), keys.end());
+  vector<scene::face_index> result(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) result[i] = keys[i].second;
+  return result;
+}
+
+struct reordering_statistics {
+  float64 acmr_before{};
+  float64 acmr_after{};
+  chrono::duration<float64> time{};
+};
+
+/// Permute vertices, faces, and the adjacency of the scene by the given
+/// method and measure the ACMR before and after.
+/// Reverse Cuthill-McKee generates the adjacency if it is missing.
+///
+inline auto reorder(scene& s, reordering method, uint32 cache_size = 16)
+    -> reordering_statistics {
+  DEMO_TRACE_SCOPE("reorder");
+  const auto start = chrono::steady_clock::now();
+  reordering_statistics stats{
+      .acmr_before = average_cache_miss_ratio(s, cache_size)};
+  switch (method) {
+    case reordering::morton:
+      s.reorder_vertices(morton_order(s));
+      s.reorder_faces(face_order_by_vertices(s));
+      break;
+    case reordering::rcm:
+      if (s.neighbor_offsets.empty()) s.generate_edges();
+      s.reorder_vertices(reverse_cuthill_mckee_order(s));
+      s.reorder_faces(face_order_by_vertices(s));
+      break;
+    case reordering::tipsify:
+      s.reorder_faces(tipsify_order(s, cache_size));
+      s.reorder_vertices(first_use_order(s));
+      break;
+    default:
+      break;
+  }
+  stats.acmr_after = average_cache_miss_ratio(s, cache_size);
+  stats.time = chrono::steady_clock::now() - start;
+  return stats;
+}
+
+}  // namespace demo
@@ -3,10 +3,31 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
+//
+#include "mapped_file.hpp"
+#include "obj_import.hpp"
+#include "ply_import.hpp"
 
 namespace demo {
 
+namespace {
+
+/// Generate the vertex normals of the scene and print the time needed
+/// and the number of isolated vertices that were left without a normal.
+///
+void generate_normals(scene& scene) {
+  const auto stats = scene.generate_normals();
+  println("Generated normals in {:.3f} s.", stats.time.count());
+  if (stats.isolated_vertices)
+    println("Left {} isolated vertices without normals.",
+            stats.isolated_vertices);
+}
+
+}  // namespace
+
 auto scene_from(const filesystem::path& path) -> scene {
+  DEMO_TRACE_SCOPE("scene_from");
+
   // Generate functor for prefixed error messages.
   //
   const auto throw_error = [&](czstring str) {
@@ -16,14 +37,56 @@ auto scene_from(const filesystem::path& path) -> scene {
 
   if (!exists(path)) throw_error("The path does not exist.");
 
+  // STL files are loaded natively as triangle soups.
+  // Welding then restores the connectivity of the surface.
+  // Facet normals are often missing or inconsistent.
+  // So, vertex normals are recomputed from the welded faces.
+  //
+  auto extension = path.extension().string();
+  for (auto& c : extension) c = tolower(c);
+  if (extension == ".stl") {
+    auto scene = scene_from(stl_surface{path});
+    const auto stats = scene.weld_vertices();
+    println("Welded {} STL vertices into {} in {:.3f} s.",
+            stats.vertices_before, stats.vertices_after, stats.time.count());
+    if (stats.removed_faces)
+      println("Removed {} degenerate faces.", stats.removed_faces);
+    generate_normals(scene);
+    return scene;
+  }
+
+  // OBJ and binary little-endian PLY files are parsed natively
+  // straight into the scene. Their faces already share vertices.
+  // Normals are generated unless the PLY file provides them.
+  // Other variants of PLY files are left to Assimp.
+  //
+  if (extension == ".obj") {
+    const mapped_file file{path};
+    auto scene = scene_from_obj_data(file.content());
+    generate_normals(scene);
+    return scene;
+  }
+  if (extension == ".ply") {
+    const mapped_file file{path};
+    if (auto scene = scene_from_ply_data(file.content())) {
+      if (std::ranges::all_of(scene->vertices, [](const auto& v) {
+            return v.normal == vec3{};
+          }))
+        generate_normals(*scene);
+      return std::move(*scene);
+    }
+  }
+
   Assimp::Importer importer{};
 
   // Assimp only needs to generate a continuously connected scene.
   // So, a lot of information can be stripped from vertices.
+  // Normals are stripped as well. Otherwise, vertices with different
+  // normals would not be joined. They are generated afterwards.
   //
   importer.SetPropertyInteger(
       AI_CONFIG_PP_RVC_FLAGS,
-      /*aiComponent_NORMALS |*/ aiComponent_TANGENTS_AND_BITANGENTS |
+      aiComponent_NORMALS | aiComponent_TANGENTS_AND_BITANGENTS |
           aiComponent_COLORS |
           /*aiComponent_TEXCOORDS |*/ aiComponent_BONEWEIGHTS |
           aiComponent_ANIMATIONS | aiComponent_TEXTURES | aiComponent_LIGHTS |
@@ -33,14 +96,17 @@ auto scene_from(const filesystem::path& path) -> scene {
   // certain post processing steps are mandatory.
   //
   const auto post_processing =
-      aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals |
+      aiProcess_Triangulate | aiProcess_FlipUVs |
       aiProcess_JoinIdenticalVertices | aiProcess_RemoveComponent |
       /*aiProcess_OptimizeMeshes |*/ /*aiProcess_OptimizeGraph |*/
       aiProcess_FindDegenerates /*| aiProcess_DropNormals*/;
 
   // Now, let Assimp actually load a scene scene from the given file.
   //
-  const auto input = importer.ReadFile(path.c_str(), post_processing);
+  const auto input = [&] {
+    DEMO_TRACE_SCOPE("Assimp::Importer::ReadFile");
+    return importer.ReadFile(path.c_str(), post_processing);
+  }();
 
   // Check whether Assimp could load the file at all.
   //
@@ -50,6 +116,7 @@ auto scene_from(const filesystem::path& path) -> scene {
   // Now, transform the loaded mesh data from
   // Assimp's internal structure to a polyhedral scene.
   //
+  DEMO_TRACE_SCOPE("copy Assimp scene");
   struct scene scene{};
 
   // First, get the total number of vertices
@@ -74,13 +141,10 @@ auto scene_from(const filesystem::path& path) -> scene {
     // Vertices of the Mesh
     //
     for (size_t vid = 0; vid < input->mMeshes[mid]->mNumVertices; ++vid) {
-      scene.vertices[vid + vertex_offset] = {
-          .position = {input->mMeshes[mid]->mVertices[vid].x,  //
-                       input->mMeshes[mid]->mVertices[vid].y,  //
-                       input->mMeshes[mid]->mVertices[vid].z},
-          .normal = {input->mMeshes[mid]->mNormals[vid].x,  //
-                     input->mMeshes[mid]->mNormals[vid].y,  //
-                     input->mMeshes[mid]->mNormals[vid].z}};
+      scene.vertices[vid + vertex_offset].position = {
+          input->mMeshes[mid]->mVertices[vid].x,  //
+          input->mMeshes[mid]->mVertices[vid].y,  //
+          input->mMeshes[mid]->mVertices[vid].z};
     }
 
     // Faces of the Mesh
@@ -104,6 +168,7 @@ auto scene_from(const filesystem::path& path) -> scene {
     face_offset += input->mMeshes[mid]->mNumFaces;
   }
 
+  generate_normals(scene);
   return scene;
 }
 
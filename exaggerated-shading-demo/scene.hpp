@@ -1,9 +1,21 @@
 #pragma once
+#include <atomic>
+//
 #include "aabb.hpp"
+#include "normal_encoding.hpp"
+#include "parallel.hpp"
 #include "stl_surface.hpp"
+#include "tracing.hpp"
 
 namespace demo {
 
+/// Weights of face normals in the average of vertex normals
+///
+enum class normal_weighting : uint32 {
+  area = 0,   // by the area of the face
+  angle = 1,  // by the interior angle of the face at the vertex
+};
+
 struct scene {
   using size_type = uint32;
   static constexpr size_type invalid = -1;
@@ -23,70 +35,603 @@ struct scene {
   // };
   using face_index = size_type;
 
-  struct edge : array<vertex_index, 2> {
-    struct info {
-      face_index face;
-    };
-
-    struct hasher {
-      auto operator()(const edge& e) const noexcept -> size_t {
-        return (size_t(e[0]) << 7) ^ size_t(e[1]);
-      }
-    };
-  };
-
   vector<vertex> vertices{};
   vector<face> faces{};
 
-  unordered_map<edge, edge::info, edge::hasher> edges{};
+  // Adjacency in compressed sparse row (CSR) format.
+  // The sorted neighbors of vertex 'v' are stored in the range
+  // [neighbor_offsets[v], neighbor_offsets[v + 1]) of 'neighbors'.
+  // For every such directed edge, 'neighbor_faces' stores a face
+  // in which it occurs.
+  //
   vector<vertex_index> neighbor_offsets{};
   vector<vertex_index> neighbors{};
+  vector<face_index> neighbor_faces{};
 
-  vector<vec4> smoothed_normals{};
+  // All levels of smoothed normals stored one after another
+  // as 'words_per_normal(smoothed_normal_encoding)' words per normal.
+  //
+  normal_encoding smoothed_normal_encoding = normal_encoding::float4;
+  vector<uint32> smoothed_normals{};
 
-  void generate_edges() {
-    edges.clear();
-    for (size_t i = 0; i < faces.size(); ++i) {
+  // The last computed level of smoothed normals in full precision
+  // as structure of arrays and the number of levels it was computed for.
+  // Adding levels continues from it while it is the last stored level.
+  //
+  array<vector<real>, 3> full_precision_level{};
+  size_type full_precision_scales = 0;
+
+  /// Decode the smoothed normal of vertex 'vid' at the given level.
+  ///
+  auto smoothed_normal(size_type level, vertex_index vid) const noexcept
+      -> vec3 {
+    const auto words = words_per_normal(smoothed_normal_encoding);
+    return decode(smoothed_normal_encoding,
+                  &smoothed_normals[(size_t(level) * vertices.size() + vid) *
+                                    words]);
+  }
+
+  // Vertex-face adjacency in CSR format. The faces of vertex 'v'
+  // are stored in ascending order in the range
+  // [offsets[v], offsets[v + 1]) of 'faces'.
+  //
+  struct vertex_face_adjacency {
+    vector<face_index> offsets{};
+    vector<face_index> faces{};
+  };
+
+  /// Build the vertex-face adjacency by a parallel counting sort.
+  /// Faces are counted and scattered into their vertex buckets in
+  /// parallel by atomic increments. The scatter order depends on the
+  /// threads. So, every bucket is sorted afterwards to keep its faces
+  /// in ascending order independent of the thread count.
+  ///
+  auto vertex_faces() const -> vertex_face_adjacency {
+    const auto n = vertices.size();
+    vertex_face_adjacency result{};
+    auto& offsets = result.offsets;
+    offsets.assign(n + 1, 0);
+    parallel_for(faces.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i)
+        for (const auto v : faces[i])
+          atomic_ref{offsets[v + 1]}.fetch_add(1, memory_order_relaxed);
+    });
+    for (size_t v = 0; v < n; ++v) offsets[v + 1] += offsets[v];
+
+    result.faces.resize(offsets.back());
+    auto cursor = offsets;
+    parallel_for(faces.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i)
+        for (const auto v : faces[i])
+          result.faces[atomic_ref{cursor[v]}.fetch_add(
+              1, memory_order_relaxed)] = face_index(i);
+    });
+
+    parallel_for(n, [&](size_t first, size_t last) {
+      for (auto v = first; v < last; ++v)
+        std::sort(result.faces.begin() + offsets[v],
+                  result.faces.begin() + offsets[v + 1]);
+    });
+    return result;
+  }
+
+  struct normal_statistics {
+    // Vertices without any adjacent face of positive area
+    size_type isolated_vertices{};
+    chrono::duration<float64> time{};
+  };
+
+  /// Set every vertex normal to the weighted average of the normals
+  /// of its adjacent faces. Isolated vertices get a zero normal.
+  /// Face normals are computed in parallel over faces. Every vertex then
+  /// gathers them over the vertex-face adjacency in parallel over
+  /// vertices. So, no two threads accumulate into the same vertex and
+  /// the summation order does not depend on the number of threads.
+  ///
+  auto generate_normals(normal_weighting weighting = normal_weighting::area)
+      -> normal_statistics {
+    DEMO_TRACE_SCOPE("generate_normals");
+    const auto start = chrono::steady_clock::now();
+    const auto adjacency = vertex_faces();
+
+    // The cross product of two face edges is twice the area in length.
+    // So, summing them directly weights every face by its area.
+    //
+    vector<vec3> face_normals(faces.size());
+    parallel_for(faces.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) {
+        const auto& [a, b, c] = faces[i];
+        const auto& p = vertices[a].position;
+        face_normals[i] =
+            cross(vertices[b].position - p, vertices[c].position - p);
+      }
+    });
+
+    // Angle weighting scales the unit normal of the face
+    // by its interior angle at the vertex.
+    //
+    const auto corner_normal = [&](face_index i, vertex_index v) {
+      auto n = face_normals[i];
+      if (weighting == normal_weighting::area) return n;
       const auto& f = faces[i];
-      edges[edge{f[0], f[1]}].face = i;
-      edges[edge{f[1], f[2]}].face = i;
-      edges[edge{f[2], f[0]}].face = i;
-    }
+      const auto k = (f[0] == v) ? 0 : (f[1] == v) ? 1 : 2;
+      const auto& p = vertices[v].position;
+      const auto u = vertices[f[(k + 1) % 3]].position - p;
+      const auto w = vertices[f[(k + 2) % 3]].position - p;
+      const auto l = length(n);
+      if (l > 0) n *= std::atan2(length(cross(u, w)), dot(u, w)) / l;
+      return n;
+    };
+
+    const auto chunks = chunk_count(vertices.size());
+    vector<size_type> isolated(chunks);
+    parallel_for_chunks(chunks, [&](size_t chunk) {
+      const auto first = chunk_begin(chunk, vertices.size(), chunks);
+      const auto last = chunk_begin(chunk + 1, vertices.size(), chunks);
+      for (auto v = first; v < last; ++v) {
+        vec3 n{};
+        for (auto k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; ++k)
+          n += corner_normal(adjacency.faces[k], v);
+        const auto l = length(n);
+        if (l > 0)
+          n /= l;
+        else
+          ++isolated[chunk];
+        vertices[v].normal = n;
+      }
+    });
+
+    normal_statistics stats{};
+    for (const auto count : isolated) stats.isolated_vertices += count;
+    stats.time = chrono::steady_clock::now() - start;
+    return stats;
+  }
+
+  struct weld_statistics {
+    size_type vertices_before{};
+    size_type vertices_after{};
+    size_type removed_faces{};
+    chrono::duration<float64> time{};
+  };
+
+  /// Merge vertices with equal positions into shared vertices and remap
+  /// the faces accordingly. For a positive 'epsilon', positions are snapped
+  /// to a grid with that cell size and all vertices of a cell are merged.
+  /// A merged vertex keeps the first position and the averaged normal.
+  /// Faces that collapse to a line or a point are removed.
+  ///
+  auto weld_vertices(real epsilon = 0) -> weld_statistics {
+    DEMO_TRACE_SCOPE("weld_vertices");
+    const auto start = chrono::steady_clock::now();
+    weld_statistics stats{.vertices_before = size_type(vertices.size())};
+
+    // Sorting vertices by their quantized position
+    // moves all vertices to be merged next to each other.
+    // The vertex index breaks ties to make the order unique.
+    //
+    struct entry {
+      array<uint64_t, 3> key;
+      vertex_index index;
+      auto operator<(const entry& e) const noexcept {
+        return tie(key[0], key[1], key[2], index) <
+               tie(e.key[0], e.key[1], e.key[2], e.index);
+      }
+    };
+    vector<entry> entries(vertices.size());
+    parallel_for(vertices.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) {
+        const auto& p = vertices[i].position;
+        auto& key = entries[i].key;
+        // Grid cells are identified by their floored index as a double.
+        // Unlike an integer, it cannot overflow for small cell sizes and
+        // large coordinates. Unlike a float, it keeps distinct positions
+        // apart if cells are smaller than the spacing of floats.
+        // Adding zero maps negative zero to positive zero.
+        for (int k = 0; k < 3; ++k)
+          key[k] = (epsilon > 0)
+                       ? bit_cast<uint64_t>(
+                             std::floor(float64(p[k]) / epsilon) + 0.0)
+                       : bit_cast<uint32>(p[k] + 0.0f);
+        entries[i].index = i;
+      }
+    });
+    parallel_sort(entries.begin(), entries.end());
+
+    const auto group_head = [&](size_t i) {
+      while ((i > 0) && (entries[i - 1].key == entries[i].key)) --i;
+      return i;
+    };
+
+    // Every vertex is represented by the vertex
+    // with the smallest index in its group.
+    //
+    vector<vertex_index> representative(vertices.size());
+    parallel_for(entries.size(), [&](size_t first, size_t last) {
+      if (first == last) return;
+      auto head = group_head(first);
+      for (auto i = first; i < last; ++i) {
+        if (entries[i].key != entries[head].key) head = i;
+        representative[entries[i].index] = entries[head].index;
+      }
+    });
+
+    // Representatives keep their relative order.
+    // So, new indices are given by a parallel prefix sum.
+    //
+    vector<vertex_index> remap(vertices.size());
+    const auto chunks = chunk_count(vertices.size());
+    vector<size_type> counts(chunks + 1);
+    parallel_for_chunks(chunks, [&](size_t c) {
+      const auto first = chunk_begin(c, vertices.size(), chunks);
+      const auto last = chunk_begin(c + 1, vertices.size(), chunks);
+      for (auto i = first; i < last; ++i)
+        counts[c + 1] += (representative[i] == i);
+    });
+    for (size_t c = 0; c < chunks; ++c) counts[c + 1] += counts[c];
+    parallel_for_chunks(chunks, [&](size_t c) {
+      const auto first = chunk_begin(c, vertices.size(), chunks);
+      const auto last = chunk_begin(c + 1, vertices.size(), chunks);
+      auto id = counts[c];
+      for (auto i = first; i < last; ++i)
+        if (representative[i] == i) remap[i] = id++;
+    });
+    // Representatives are not written again. So, other threads
+    // may read their new indices concurrently.
+    //
+    parallel_for(vertices.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i)
+        if (representative[i] != i) remap[i] = remap[representative[i]];
+    });
+
+    // Every group is gathered by the thread that owns its head.
+    //
+    vector<vertex> welded(counts[chunks]);
+    parallel_for(entries.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) {
+        if ((i > 0) && (entries[i - 1].key == entries[i].key)) continue;
+        const auto& v = vertices[entries[i].index];
+        auto n = v.normal;
+        for (auto j = i + 1;
+             (j < entries.size()) && (entries[j].key == entries[i].key); ++j)
+          n += vertices[entries[j].index].normal;
+        // Opposite normals may cancel out each other.
+        const auto l = length(n);
+        welded[remap[entries[i].index]] = {
+            .position = v.position, .normal = (l > 0) ? n / l : v.normal};
+      }
+    });
+    vertices = std::move(welded);
 
+    // Remap faces and remove the degenerate ones by another prefix sum.
+    //
+    const auto face_chunks = chunk_count(faces.size());
+    vector<size_type> face_counts(face_chunks + 1);
+    parallel_for_chunks(face_chunks, [&](size_t c) {
+      const auto first = chunk_begin(c, faces.size(), face_chunks);
+      const auto last = chunk_begin(c + 1, faces.size(), face_chunks);
+      for (auto i = first; i < last; ++i) {
+        auto& f = faces[i];
+        for (auto& v : f) v = remap[v];
+        face_counts[c + 1] +=
+            (f[0] != f[1]) && (f[1] != f[2]) && (f[2] != f[0]);
+      }
+    });
+    for (size_t c = 0; c < face_chunks; ++c)
+      face_counts[c + 1] += face_counts[c];
+    vector<face> welded_faces(face_counts[face_chunks]);
+    parallel_for_chunks(face_chunks, [&](size_t c) {
+      const auto first = chunk_begin(c, faces.size(), face_chunks);
+      const auto last = chunk_begin(c + 1, faces.size(), face_chunks);
+      auto id = face_counts[c];
+      for (auto i = first; i < last; ++i) {
+        const auto& f = faces[i];
+        if ((f[0] != f[1]) && (f[1] != f[2]) && (f[2] != f[0]))
+          welded_faces[id++] = f;
+      }
+    });
+    stats.removed_faces = faces.size() - welded_faces.size();
+    faces = std::move(welded_faces);
+
+    stats.vertices_after = vertices.size();
+    stats.time = chrono::steady_clock::now() - start;
+    return stats;
+  }
+
+  /// Build the CSR adjacency from the directed edges of all faces
+  /// by a counting sort over the source vertex.
+  /// Edges that occur in multiple faces are only stored once
+  /// and refer to the face with the largest index.
+  ///
+  void generate_edges() {
+    DEMO_TRACE_SCOPE("generate_edges");
+    // Count outgoing edges for every vertex.
+    //
     neighbor_offsets.assign(vertices.size() + 1, 0);
-    for (const auto& [e, _] : edges) {
-      const auto vid = e[0];
-      const auto nid = e[1];
-      ++neighbor_offsets[vid];
-    }
-    for (size_type i = 0; i < vertices.size(); ++i)
+    for (const auto& f : faces)
+      for (auto v : f) ++neighbor_offsets[v + 1];
+    for (size_t i = 0; i < vertices.size(); ++i)
       neighbor_offsets[i + 1] += neighbor_offsets[i];
-    neighbors.resize(neighbor_offsets.back());
-    for (const auto& [e, _] : edges) {
-      const auto vid = e[0];
-      const auto nid = e[1];
-      neighbors[--neighbor_offsets[vid]] = nid;
+
+    // Scatter all edges into their vertex buckets. Every entry packs
+    // the target vertex into its high bits and the face into its low bits.
+    // So, sorting entries sorts the neighbors and keeps faces in order.
+    //
+    vector<uint64_t> entries(neighbor_offsets.back());
+    {
+      auto cursor = neighbor_offsets;
+      for (face_index i = 0; i < faces.size(); ++i) {
+        const auto& f = faces[i];
+        for (int k = 0; k < 3; ++k)
+          entries[cursor[f[k]]++] = (uint64_t(f[(k + 1) % 3]) << 32) | i;
+      }
     }
+
+    // Sort the buckets and count unique neighbors in parallel.
+    //
+    vector<vertex_index> degrees(vertices.size() + 1);
+    parallel_for(vertices.size(), [&](size_t first, size_t last) {
+      for (auto v = first; v < last; ++v) {
+        const auto begin = entries.begin() + neighbor_offsets[v];
+        const auto end = entries.begin() + neighbor_offsets[v + 1];
+        std::sort(begin, end);
+        vertex_index degree = 0;
+        for (auto it = begin; it != end; ++it)
+          degree += ((it + 1 == end) || ((*it >> 32) != (*(it + 1) >> 32)));
+        degrees[v + 1] = degree;
+      }
+    });
+    for (size_t i = 0; i < vertices.size(); ++i)
+      degrees[i + 1] += degrees[i];
+
+    // Write the last entry of every run of equal neighbors.
+    //
+    neighbors.resize(degrees.back());
+    neighbor_faces.resize(degrees.back());
+    parallel_for(vertices.size(), [&](size_t first, size_t last) {
+      for (auto v = first; v < last; ++v) {
+        auto k = degrees[v];
+        const auto end = neighbor_offsets[v + 1];
+        for (auto i = neighbor_offsets[v]; i < end; ++i) {
+          if ((i + 1 != end) && ((entries[i] >> 32) == (entries[i + 1] >> 32)))
+            continue;
+          neighbors[k] = entries[i] >> 32;
+          neighbor_faces[k] = entries[i] & 0xffffffff;
+          ++k;
+        }
+      }
+    });
+    neighbor_offsets = std::move(degrees);
   }
 
-  void smooth_normals(size_type scales) {
-    smoothed_normals.resize(vertices.size() * scales);
-    for (vertex_index vid = 0; vid < vertices.size(); ++vid) {
-      auto n = vertices[vid].normal;
-      for (auto k = neighbor_offsets[vid]; k < neighbor_offsets[vid + 1]; ++k)
-        n += vertices[neighbors[k]].normal;
-      smoothed_normals[vid] = vec4(normalize(n), 0.0);
+  /// Return a face containing the directed edge from 'from' to 'to'.
+  /// If there is no such edge, 'invalid' is returned.
+  /// The lookup is a binary search over the sorted neighbors of 'from'.
+  ///
+  auto edge_face(vertex_index from, vertex_index to) const noexcept
+      -> face_index {
+    const auto first = neighbors.begin() + neighbor_offsets[from];
+    const auto last = neighbors.begin() + neighbor_offsets[from + 1];
+    const auto it = std::lower_bound(first, last, to);
+    if ((it == last) || (*it != to)) return invalid;
+    return neighbor_faces[it - neighbors.begin()];
+  }
+
+  /// Renumber vertices such that the new vertex 'i' is the old vertex
+  /// 'order[i]'. Faces, the CSR adjacency, and all levels of smoothed
+  /// normals are permuted consistently.
+  ///
+  void reorder_vertices(span<const vertex_index> order) {
+    DEMO_TRACE_SCOPE("reorder_vertices");
+    const auto n = vertices.size();
+    assert(order.size() == n);
+    vector<vertex_index> remap(n);
+    parallel_for(n, [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) remap[order[i]] = i;
+    });
+
+    vector<vertex> permuted(n);
+    parallel_for(n, [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) permuted[i] = vertices[order[i]];
+    });
+    vertices = std::move(permuted);
+
+    parallel_for(faces.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i)
+        for (auto& v : faces[i]) v = remap[v];
+    });
+
+    if (!smoothed_normals.empty()) {
+      const auto words = words_per_normal(smoothed_normal_encoding);
+      const auto levels = smoothed_normals.size() / (n * words);
+      vector<uint32> normals(smoothed_normals.size());
+      parallel_for(n, [&](size_t first, size_t last) {
+        for (size_t level = 0; level < levels; ++level)
+          for (auto i = first; i < last; ++i)
+            std::copy_n(&smoothed_normals[(level * n + order[i]) * words],
+                        words, &normals[(level * n + i) * words]);
+      });
+      smoothed_normals = std::move(normals);
     }
-    for (int i = 1; i < scales; ++i) {
-      const auto offset = i * vertices.size();
-      const auto offset_1 = (i - 1) * vertices.size();
-      for (vertex_index vid = 0; vid < vertices.size(); ++vid) {
-        auto n = smoothed_normals[offset_1 + vid];
-        for (auto k = neighbor_offsets[vid]; k < neighbor_offsets[vid + 1]; ++k)
-          n += smoothed_normals[offset_1 + neighbors[k]];
-        smoothed_normals[offset + vid] = normalize(n);
+
+    for (auto& component : full_precision_level) {
+      if (component.empty()) continue;
+      vector<real> permuted(n);
+      parallel_for(n, [&](size_t first, size_t last) {
+        for (auto i = first; i < last; ++i) permuted[i] = component[order[i]];
+      });
+      component = std::move(permuted);
+    }
+
+    if (neighbor_offsets.empty()) return;
+
+    // Neighbors keep their faces but get new indices.
+    // So, every bucket is moved to its new vertex and sorted again
+    // with the same packed entries as in 'generate_edges'.
+    //
+    vector<vertex_index> offsets(n + 1);
+    for (size_t i = 0; i < n; ++i)
+      offsets[i + 1] = offsets[i] + neighbor_offsets[order[i] + 1] -
+                       neighbor_offsets[order[i]];
+    vector<uint64_t> entries(neighbors.size());
+    parallel_for(n, [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) {
+        auto k = offsets[i];
+        for (auto j = neighbor_offsets[order[i]];
+             j < neighbor_offsets[order[i] + 1]; ++j)
+          entries[k++] = (uint64_t(remap[neighbors[j]]) << 32) |
+                         neighbor_faces[j];
+        std::sort(entries.begin() + offsets[i], entries.begin() + k);
+      }
+    });
+    parallel_for(entries.size(), [&](size_t first, size_t last) {
+      for (auto k = first; k < last; ++k) {
+        neighbors[k] = entries[k] >> 32;
+        neighbor_faces[k] = entries[k] & 0xffffffff;
       }
+    });
+    neighbor_offsets = std::move(offsets);
+  }
+
+  /// Reorder faces such that the new face 'i' is the old face 'order[i]'.
+  /// The CSR adjacency is generated again. Renumbering its faces would
+  /// not keep the face with the largest index for shared edges.
+  ///
+  void reorder_faces(span<const face_index> order) {
+    DEMO_TRACE_SCOPE("reorder_faces");
+    assert(order.size() == faces.size());
+    vector<face> permuted(faces.size());
+    parallel_for(faces.size(), [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) permuted[i] = faces[order[i]];
+    });
+    faces = std::move(permuted);
+
+    if (!neighbor_offsets.empty()) generate_edges();
+  }
+
+  struct smoothing_statistics {
+    // Largest angle in radians between an exact and a decoded normal.
+    real max_error{};
+    chrono::duration<float64> time{};
+  };
+
+  /// Compute 'scales' levels of smoothed normals. Every level averages
+  /// the normals of the previous level over the one-ring of each vertex.
+  /// Within a level, all vertices are independent and processed in parallel.
+  /// The summation order per vertex is fixed. So, the results do not
+  /// depend on the number of threads.
+  /// Levels are computed in full precision and only their output is
+  /// stored with the given encoding. So, encoding errors do not accumulate.
+  ///
+  auto smooth_normals(size_type scales,
+                      normal_encoding encoding = normal_encoding::float4)
+      -> smoothing_statistics {
+    smoothed_normal_encoding = encoding;
+    smoothed_normals.clear();
+    return resize_smoothed_normals(scales);
+  }
+
+  /// Number of stored levels of smoothed normals.
+  ///
+  auto smoothed_scales() const noexcept -> size_type {
+    if (vertices.empty()) return 0;
+    return smoothed_normals.size() /
+           (vertices.size() * words_per_normal(smoothed_normal_encoding));
+  }
+
+  /// Change the number of stored levels of smoothed normals.
+  /// Removing levels only shrinks the storage. Adding levels continues
+  /// the smoothing from the last stored level. So, only new levels are
+  /// computed and all others keep their position in the storage.
+  /// The last level is kept in full precision. So, adding levels gives
+  /// the same result as computing all of them at once. Only after
+  /// removing levels or loading them from a cache, the last level has
+  /// to be decoded first, like on the GPU. For lossy encodings,
+  /// its encoding error then enters the new levels once.
+  ///
+  auto resize_smoothed_normals(size_type scales) -> smoothing_statistics {
+    DEMO_TRACE_SCOPE("smooth_normals");
+    const auto start = chrono::steady_clock::now();
+    const auto n = vertices.size();
+    const auto encoding = smoothed_normal_encoding;
+    const auto words = words_per_normal(encoding);
+    const auto existing = smoothed_scales();
+    smoothed_normals.resize(n * scales * words);
+    if (scales <= existing)
+      return {.time = chrono::steady_clock::now() - start};
+
+    // The previous and the current level are kept as structure of arrays.
+    // Gathering then only touches the components it needs and the
+    // normalization runs over contiguous arrays that can be vectorized.
+    //
+    array<vector<real>, 3> previous{};
+    array<vector<real>, 3> current{vector<real>(n), vector<real>(n),
+                                   vector<real>(n)};
+    if ((existing > 0) && (full_precision_scales == existing))
+      previous = std::move(full_precision_level);
+    else {
+      for (auto& component : previous) component.resize(n);
+      parallel_for(n, [&](size_t first, size_t last) {
+        for (auto vid = first; vid < last; ++vid) {
+          const auto normal = (existing == 0)
+                                  ? vertices[vid].normal
+                                  : smoothed_normal(existing - 1, vid);
+          for (int k = 0; k < 3; ++k) previous[k][vid] = normal[k];
+        }
+      });
+    }
+
+    // Every chunk tracks its own maximum of the encoding error.
+    vector<real> max_errors(chunk_count(n));
+
+    for (auto i = existing; i < scales; ++i) {
+      const auto offset = size_t(i) * n;
+      parallel_for_chunks(max_errors.size(), [&](size_t chunk) {
+        const auto first = chunk_begin(chunk, n, max_errors.size());
+        const auto last = chunk_begin(chunk + 1, n, max_errors.size());
+
+        for (int c = 0; c < 3; ++c) {
+          const auto src = previous[c].data();
+          const auto dst = current[c].data();
+          for (auto vid = first; vid < last; ++vid) {
+            auto x = src[vid];
+            for (auto k = neighbor_offsets[vid]; k < neighbor_offsets[vid + 1];
+                 ++k)
+              x += src[neighbors[k]];
+            dst[vid] = x;
+          }
+        }
+
+        const auto x = current[0].data();
+        const auto y = current[1].data();
+        const auto z = current[2].data();
+        for (auto vid = first; vid < last; ++vid) {
+          const auto s = real(1) / sqrt(x[vid] * x[vid] + y[vid] * y[vid] +
+                                        z[vid] * z[vid]);
+          x[vid] *= s;
+          y[vid] *= s;
+          z[vid] *= s;
+        }
+
+        auto& max_error = max_errors[chunk];
+        for (auto vid = first; vid < last; ++vid) {
+          const vec3 normal{x[vid], y[vid], z[vid]};
+          const auto out = &smoothed_normals[(offset + vid) * words];
+          encode(encoding, normal, out);
+          if (encoding == normal_encoding::float4) continue;
+          // Small angles are badly conditioned for 'acos'.
+          const auto decoded = decode(encoding, out);
+          max_error = std::max(
+              max_error,
+              std::atan2(length(cross(decoded, normal)), dot(decoded, normal)));
+        }
+      });
+      swap(previous, current);
     }
+    full_precision_level = std::move(previous);
+    full_precision_scales = scales;
+
+    return {.max_error = *std::ranges::max_element(max_errors),
+            .time = chrono::steady_clock::now() - start};
   }
 };
 
@@ -108,6 +653,7 @@ inline auto scene_from(const stl_surface& stl) -> scene {
 }
 
 inline auto aabb_from(const scene& s) noexcept -> aabb3 {
+  DEMO_TRACE_SCOPE("aabb_from");
   aabb3 result{};
   for (const auto& v : s.vertices) result = aabb{result, v.position};
   return result;
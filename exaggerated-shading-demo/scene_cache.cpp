@@ -0,0 +1,231 @@
+#include "scene_cache.hpp"
+//
+#include <cstdlib>
+//
+#include "mapped_file.hpp"
+
+namespace demo {
+
+namespace {
+
+struct cache_header {
+  array<char, 8> magic{'E', 'S', 'D', 'S', 'C', 'E', 'N', 'E'};
+  uint32 version = scene_cache_version;
+  uint32 scales{};
+  normal_encoding encoding{};
+  reordering order{};
+  uint32 vertex_count{};
+  uint32 face_count{};
+  uint32 neighbor_count{};
+  uint64_t normal_word_count{};
+  uint64_t source_size{};
+  int64_t source_time{};
+  uint64_t source_hash{};
+};
+static_assert(is_trivially_copyable_v<cache_header>);
+
+/// Hash the file content in fixed-size blocks on all cores.
+/// Blocks are combined in order. So, the result
+/// does not depend on the number of threads.
+///
+auto content_hash(string_view data) -> uint64_t {
+  constexpr size_t block_size = size_t{1} << 20;
+  const auto mix = [](uint64_t h, uint64_t w) {
+    h ^= w * 0x9e3779b97f4a7c15ull;
+    h = rotl(h, 31) * 0xbf58476d1ce4e5b9ull;
+    return h ^ (h >> 29);
+  };
+  const auto blocks = (data.size() + block_size - 1) / block_size;
+  vector<uint64_t> hashes(blocks);
+  parallel_for(
+      blocks,
+      [&](size_t first, size_t last) {
+        for (auto b = first; b < last; ++b) {
+          const auto block = data.substr(b * block_size, block_size);
+          uint64_t h = b;
+          size_t i = 0;
+          for (; i + 8 <= block.size(); i += 8) {
+            uint64_t w;
+            memcpy(&w, block.data() + i, sizeof(w));
+            h = mix(h, w);
+          }
+          for (; i < block.size(); ++i) h = mix(h, uint8(block[i]));
+          hashes[b] = h;
+        }
+      },
+      1);
+  uint64_t result = data.size();
+  for (auto h : hashes) result = mix(result, h);
+  return result;
+}
+
+auto source_time(const filesystem::path& source) -> int64_t {
+  return last_write_time(source).time_since_epoch().count();
+}
+
+auto cache_directory() -> filesystem::path {
+  if (const auto dir = getenv("XDG_CACHE_HOME"); dir && *dir)
+    return filesystem::path{dir} / "exaggerated-shading-demo";
+  if (const auto dir = getenv("HOME"); dir && *dir)
+    return filesystem::path{dir} / ".cache" / "exaggerated-shading-demo";
+  return filesystem::temp_directory_path() / "exaggerated-shading-demo";
+}
+
+/// Sequential reader of typed arrays from the mapped cache file.
+///
+struct cache_reader {
+  string_view data;
+  size_t offset = 0;
+
+  template <typename type>
+  bool read(vector<type>& values, size_t count) {
+    const auto bytes = count * sizeof(type);
+    if (data.size() - offset < bytes) return false;
+    values.resize(count);
+    memcpy(values.data(), data.data() + offset, bytes);
+    offset += bytes;
+    return true;
+  }
+};
+
+/// Check 'p(i)' for every index in [0, n) in parallel.
+///
+template <typename predicate>
+auto parallel_all_of(size_t n, predicate&& p) -> bool {
+  const auto chunks = chunk_count(n);
+  vector<uint8> valid(chunks, true);
+  parallel_for_chunks(chunks, [&](size_t c) {
+    const auto first = chunk_begin(c, n, chunks);
+    const auto last = chunk_begin(c + 1, n, chunks);
+    for (auto i = first; (i < last) && valid[c]; ++i) valid[c] = p(i);
+  });
+  return std::ranges::all_of(valid, [](uint8 v) { return v != 0; });
+}
+
+/// Check that every index stored in the scene refers to an existing
+/// vertex or face. Otherwise, a file with the right length but corrupt
+/// or foreign content would cause out-of-bounds accesses later on.
+///
+auto valid_indices(const scene& s) -> bool {
+  const auto n = s.vertices.size();
+  const auto& offsets = s.neighbor_offsets;
+  if ((offsets.front() != 0) || (offsets.back() != s.neighbors.size()))
+    return false;
+  return parallel_all_of(
+             s.faces.size(),
+             [&](size_t i) {
+               const auto& f = s.faces[i];
+               return (f[0] < n) && (f[1] < n) && (f[2] < n);
+             }) &&
+         parallel_all_of(
+             n, [&](size_t v) { return offsets[v] <= offsets[v + 1]; }) &&
+         parallel_all_of(s.neighbors.size(), [&](size_t i) {
+           return (s.neighbors[i] < n) &&
+                  (s.neighbor_faces[i] < s.faces.size());
+         });
+}
+
+template <typename type>
+void write(ofstream& file, const vector<type>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()),
+             values.size() * sizeof(type));
+}
+
+}  // namespace
+
+auto scene_cache_path(const filesystem::path& source) -> filesystem::path {
+  const auto name = filesystem::weakly_canonical(source).string();
+  return cache_directory() /
+         format("{:016x}.scene", content_hash(string_view{name}));
+}
+
+auto load_scene_cache(const filesystem::path& source,
+                      uint32 scales,
+                      normal_encoding encoding,
+                      reordering order) -> optional<scene> try {
+  DEMO_TRACE_SCOPE("load_scene_cache");
+  const auto path = scene_cache_path(source);
+  if (!exists(path)) return nullopt;
+
+  const mapped_file file{path};
+  const auto data = file.content();
+  cache_header header{};
+  if (data.size() < sizeof(header)) return nullopt;
+  memcpy(&header, data.data(), sizeof(header));
+
+  if ((header.magic != cache_header{}.magic) ||
+      (header.version != scene_cache_version) || (header.scales != scales) ||
+      (header.encoding != encoding) || (header.order != order) ||
+      (header.source_size != file_size(source)) ||
+      (header.normal_word_count != size_t{scales} * header.vertex_count *
+                                       words_per_normal(encoding)))
+    return nullopt;
+
+  // A changed modification time alone does not invalidate the cache
+  // as long as the content is still the same.
+  if ((header.source_time != source_time(source)) &&
+      (header.source_hash != content_hash(mapped_file{source}.content())))
+    return nullopt;
+
+  scene result{};
+  result.smoothed_normal_encoding = encoding;
+  cache_reader reader{data, sizeof(header)};
+  const auto complete =
+      reader.read(result.vertices, header.vertex_count) &&
+      reader.read(result.faces, header.face_count) &&
+      reader.read(result.neighbor_offsets, header.vertex_count + size_t{1}) &&
+      reader.read(result.neighbors, header.neighbor_count) &&
+      reader.read(result.neighbor_faces, header.neighbor_count) &&
+      reader.read(result.smoothed_normals, header.normal_word_count);
+  if (!complete || !valid_indices(result)) return nullopt;
+  return result;
+} catch (const filesystem::filesystem_error&) {
+  return nullopt;
+} catch (const runtime_error&) {
+  return nullopt;
+}
+
+void store_scene_cache(const filesystem::path& source,
+                       const scene& scene,
+                       uint32 scales,
+                       reordering order) {
+  DEMO_TRACE_SCOPE("store_scene_cache");
+  const auto path = scene_cache_path(source);
+  create_directories(path.parent_path());
+
+  const cache_header header{
+      .scales = scales,
+      .encoding = scene.smoothed_normal_encoding,
+      .order = order,
+      .vertex_count = uint32(scene.vertices.size()),
+      .face_count = uint32(scene.faces.size()),
+      .neighbor_count = uint32(scene.neighbors.size()),
+      .normal_word_count = scene.smoothed_normals.size(),
+      .source_size = file_size(source),
+      .source_time = source_time(source),
+      .source_hash = content_hash(mapped_file{source}.content()),
+  };
+
+  // Write to a temporary file first and rename it afterwards.
+  // So, concurrent readers never see a partially written cache.
+  const auto tmp = filesystem::path{path}.concat(".tmp");
+  {
+    ofstream file{tmp, ios::binary | ios::trunc};
+    if (!file)
+      throw runtime_error(
+          format("Failed to create scene cache file '{}'.", tmp.string()));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write(file, scene.vertices);
+    write(file, scene.faces);
+    write(file, scene.neighbor_offsets);
+    write(file, scene.neighbors);
+    write(file, scene.neighbor_faces);
+    write(file, scene.smoothed_normals);
+    if (!file)
+      throw runtime_error(
+          format("Failed to write scene cache file '{}'.", tmp.string()));
+  }
+  filesystem::rename(tmp, path);
+}
+
+}  // namespace demo
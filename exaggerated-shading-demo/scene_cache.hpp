@@ -0,0 +1,36 @@
+#pragma once
+#include "reordering.hpp"
+#include "scene.hpp"
+
+namespace demo {
+
+/// Versioned binary cache of fully processed scenes on disk.
+/// A cache file stores vertices, faces, the CSR adjacency, and the smoothed
+/// normals of a scene together with a key of its source file.
+/// The key consists of the source size, modification time, and content hash
+/// as well as the number of scales, the normal encoding, and the reordering.
+/// The version changes whenever the processing of source files changes.
+///
+inline constexpr uint32 scene_cache_version = 5;
+
+/// The cache file of a source file inside the user's cache directory.
+///
+auto scene_cache_path(const filesystem::path& source) -> filesystem::path;
+
+/// Map the cache file of 'source' and return its scene
+/// if it exists and matches the given parameters.
+/// Stale or corrupt cache files are ignored.
+///
+auto load_scene_cache(const filesystem::path& source,
+                      uint32 scales,
+                      normal_encoding encoding,
+                      reordering order) -> optional<scene>;
+
+/// Write the processed scene to the cache file of 'source'.
+///
+void store_scene_cache(const filesystem::path& source,
+                       const scene& scene,
+                       uint32 scales,
+                       reordering order);
+
+}  // namespace demo
@@ -0,0 +1,90 @@
+#include "scene_loader.hpp"
+//
+#include "scene_cache.hpp"
+
+namespace demo {
+
+scene_loader::scene_loader(const filesystem::path& path,
+                           uint32 scales,
+                           normal_encoding encoding,
+                           reordering order)
+    : source{path},
+      scales{scales},
+      encoding{encoding},
+      order{order},
+      worker{[this](stop_token token) {
+        try {
+          run(token);
+        } catch (...) {
+          error = current_exception();
+          state = stage::failed;
+        }
+        state.notify_all();
+      }} {}
+
+void scene_loader::run(stop_token token) {
+  DEMO_TRACE_SCOPE("scene_loader::run");
+  const auto next = [&](stage s) {
+    if (token.stop_requested()) {
+      state = stage::cancelled;
+      return false;
+    }
+    state = s;
+    return true;
+  };
+
+  // Processing large scenes takes long.
+  // So, reuse the cached result of a previous run if possible.
+  //
+  if (auto cached = load_scene_cache(source, scales, encoding, order)) {
+    result = std::move(*cached);
+    println("Loaded processed scene from cache '{}'.",
+            scene_cache_path(source).string());
+    state = stage::finished;
+    return;
+  }
+
+  result = scene_from(source);
+
+  if (!next(stage::generating_edges)) return;
+  result.generate_edges();
+
+  // Reordering permutes the adjacency as well.
+  // So, it does not have to be generated again.
+  if (!next(stage::reordering)) return;
+  if (order != reordering::none) {
+    const auto stats = reorder(result, order);
+    println("Reordered scene by {} in {:.3f} s with ACMR {:.3f} -> {:.3f}.",
+            reordering_string(order), stats.time.count(), stats.acmr_before,
+            stats.acmr_after);
+  }
+
+  // Without any scales, normals are smoothed later on the GPU.
+  // Only the encoding is stored.
+  if (!next(stage::smoothing_normals)) return;
+  const auto stats = result.smooth_normals(scales, encoding);
+  if (scales > 0) {
+    println("Smoothed {} scales of normals in {:.3f} s.", scales,
+            stats.time.count());
+    println("Stored {} bytes per vertex as {} with maximum error {:.2e} rad.",
+            scales * words_per_normal(encoding) * sizeof(uint32),
+            normal_encoding_string(encoding), stats.max_error);
+  }
+
+  if (!next(stage::caching)) return;
+  try {
+    store_scene_cache(source, result, scales, order);
+  } catch (const exception& e) {
+    println("Failed to cache processed scene. {}", e.what());
+  }
+
+  state = stage::finished;
+}
+
+auto scene_loader::take() -> scene {
+  wait();
+  if (error) rethrow_exception(error);
+  return std::move(result);
+}
+
+}  // namespace demo
@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <thread>
+//
+#include "reordering.hpp"
+#include "scene.hpp"
+
+namespace demo {
+
+/// Background pipeline that loads and processes a scene on a worker thread.
+/// The scene is either taken from the cache or imported, connected,
+/// reordered, and smoothed. The render thread polls the loader and takes
+/// the finished scene for upload. Cancellation takes effect between
+/// pipeline stages.
+///
+class scene_loader {
+ public:
+  enum class stage : uint32 {
+    importing,
+    generating_edges,
+    reordering,
+    smoothing_normals,
+    caching,
+    finished,
+    failed,
+    cancelled,
+  };
+
+  scene_loader(const filesystem::path& path,
+               uint32 scales,
+               normal_encoding encoding,
+               reordering order = reordering::tipsify);
+
+  // The worker thread refers to the loader itself.
+  // So, the loader can neither be copied nor moved.
+  //
+  scene_loader(const scene_loader&) = delete;
+  scene_loader& operator=(const scene_loader&) = delete;
+
+  auto path() const noexcept -> const filesystem::path& { return source; }
+
+  auto current_stage() const noexcept -> stage { return state.load(); }
+
+  /// Whether the worker has stopped and will not modify the loader anymore.
+  ///
+  auto done() const noexcept -> bool {
+    return current_stage() >= stage::finished;
+  }
+
+  /// Request the worker to stop after its current stage.
+  ///
+  void cancel() noexcept { worker.request_stop(); }
+
+  /// Block until the worker has stopped.
+  ///
+  void wait() const noexcept {
+    for (auto s = state.load(); s < stage::finished; s = state.load())
+      state.wait(s);
+  }
+
+  /// Move the finished scene out of the loader.
+  /// Rethrows the error of a failed pipeline.
+  ///
+  auto take() -> scene;
+
+  /// Time since the pipeline has been started.
+  ///
+  auto elapsed() const noexcept -> chrono::duration<float64> {
+    return chrono::steady_clock::now() - start;
+  }
+
+ private:
+  void run(stop_token token);
+
+  filesystem::path source;
+  uint32 scales;
+  normal_encoding encoding;
+  reordering order;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  scene result{};
+  exception_ptr error{};
+  atomic<stage> state{stage::importing};
+
+  // Must be the last member. So, the thread is joined
+  // before any other member is destroyed.
+  jthread worker;
+};
+
+constexpr auto stage_string(scene_loader::stage s) noexcept -> czstring {
+  switch (s) {
+    case scene_loader::stage::importing:
+      return "importing";
+    case scene_loader::stage::generating_edges:
+      return "generating edges";
+    case scene_loader::stage::reordering:
+      return "reordering";
+    case scene_loader::stage::smoothing_normals:
+      return "smoothing normals";
+    case scene_loader::stage::caching:
+      return "caching";
+    case scene_loader::stage::finished:
+      return "finished";
+    case scene_loader::stage::failed:
+      return "failed";
+    case scene_loader::stage::cancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+/// Fraction of finished pipeline stages.
+///
+constexpr auto progress(scene_loader::stage s) noexcept -> float32 {
+  return std::min(static_cast<uint32>(s), 5u) / 5.0f;
+}
+
+}  // namespace demo
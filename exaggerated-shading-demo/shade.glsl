@@ -0,0 +1,70 @@
+// The viewer prepends the '#version' directive and the following
+// definitions to generate a specialized variant of the shader.
+//   NORMAL_ENCODING: storage of smoothed normals
+//     0: float4, 1: octahedral snorm16x2, 2: half4
+//   SCALES: number of smoothed normal levels
+//   EXAGGERATION: gain of the dot products before clamping
+//   WEIGHTS: comma-separated weights of all levels
+//   TOTAL_WEIGHT: sum of all weights including the unsmoothed normal
+
+layout (local_size_x = 256) in;
+
+// Camera and light state shared with the vertex shader
+layout (std140, binding = 0) uniform frame {
+  mat4 projection;
+  mat4 view;
+  // Light direction in model space
+  vec4 light;
+};
+
+uniform uint count = 0;
+
+layout (std430, binding = 0) readonly buffer smoothed_normals {
+  uint words[];
+};
+
+// Vertices consist of a position and a normal.
+layout (std430, binding = 1) readonly buffer vertices {
+  float vertex_data[];
+};
+
+layout (std430, binding = 2) writeonly buffer intensities {
+  float intensity[];
+};
+
+vec3 smoothed_normal(uint i) {
+#if NORMAL_ENCODING == 1
+  vec2 q = unpackSnorm2x16(words[i]);
+  vec3 m = vec3(q, 1.0 - abs(q.x) - abs(q.y));
+  float t = max(-m.z, 0.0);
+  m.xy += mix(vec2(t), vec2(-t), greaterThanEqual(m.xy, vec2(0.0)));
+  return normalize(m);
+#elif NORMAL_ENCODING == 2
+  return vec3(unpackHalf2x16(words[2u * i]), unpackHalf2x16(words[2u * i + 1u]).x);
+#else
+  return uintBitsToFloat(uvec3(words[4u * i], words[4u * i + 1u], words[4u * i + 2u]));
+#endif
+}
+
+void main() {
+  const uint id = gl_GlobalInvocationID.x;
+  if (id >= count) return;
+
+  const vec3 n = vec3(vertex_data[6u * id + 3u],
+                      vertex_data[6u * id + 4u],
+                      vertex_data[6u * id + 5u]);
+  const vec3 l = light.xyz;
+
+  const float a = EXAGGERATION;
+  float x = clamp(a * dot(n, l), -1.0, 1.0);
+#if SCALES > 0
+  const float weights[SCALES] = float[SCALES](WEIGHTS);
+  for (uint i = 0; i < SCALES; ++i)
+    x += weights[i] *
+         clamp(a * dot(l, smoothed_normal(i * count + id)), -1.0, 1.0);
+#endif
+  x /= TOTAL_WEIGHT;
+  x = 0.5 * (1.0 + x);
+  x = 0.01 * x + 0.99 * (0.5 * (1.0 + clamp(dot(n, l), -1.0, 1.0)));
+  intensity[id] = x;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "parallel.hpp"
+#include "scene.hpp"
+
+namespace demo {
+
+// CPU reference of the exaggerated shading that is otherwise
+// evaluated per vertex by the shading compute shader 'shade.glsl'.
+
+/// Directional light of the viewer given in view space.
+///
+inline const vec4 default_light{1, -1, -0.1, 0};
+
+/// Light direction in model space for a directional light given
+/// in view space. Translations of the camera do not change it.
+///
+inline auto light_direction(const mat4& view, const vec4& light) noexcept
+    -> vec3 {
+  return -normalize(vec3(inverse(view) * light));
+}
+
+/// Parameters of the exaggerated shading.
+/// Together with the number of scales,
+/// they select a specialized variant of the shading compute shader.
+///
+struct shading_profile {
+  // Gain of the dot products before clamping
+  float32 exaggeration = 2.0f;
+  // Exponent of the weight fall-off over the levels
+  float32 falloff = 0.5f;
+
+  /// Weight of the smoothed normal at the given level.
+  /// Coarser levels contribute less to the final intensity.
+  ///
+  auto weight(uint32 level) const noexcept -> float32 {
+    return std::pow(std::pow(1.0f / std::sqrt(2.0f), level + 1.0f), falloff);
+  }
+
+  friend bool operator==(const shading_profile&,
+                         const shading_profile&) noexcept = default;
+};
+
+/// Shader preamble of the specialized shading variant.
+/// The number of scales and all weights become compile-time constants.
+/// So, the shader compiler is able to fully unroll the loop over scales.
+/// The preamble also serves as key of the variant.
+///
+inline auto shading_variant_preamble(normal_encoding encoding,
+                                     uint32 scales,
+                                     const shading_profile& profile)
+    -> string {
+  auto result = format(
+      "#version 460 core\n"
+      "#define NORMAL_ENCODING {}\n"
+      "#define SCALES {}\n"
+      "#define EXAGGERATION {:.9e}\n",
+      static_cast<uint32>(encoding), scales, profile.exaggeration);
+  float32 total = 1.0f;
+  result += "#define WEIGHTS ";
+  for (uint32 i = 0; i < scales; ++i) {
+    const auto w = profile.weight(i);
+    total += w;
+    result += format("{}{:.9e}", (i > 0) ? ", " : "", w);
+  }
+  result += format("\n#define TOTAL_WEIGHT {:.9e}\n", total);
+  return result;
+}
+
+/// Shading intensity in [0, 1] of a vertex for the light direction 'l'.
+///
+inline auto exaggerated_intensity(const scene& scene,
+                                  scene::vertex_index vid,
+                                  vec3 l,
+                                  uint32 scales,
+                                  const shading_profile& profile = {}) noexcept
+    -> float32 {
+  const auto a = profile.exaggeration;
+  const auto n = scene.vertices[vid].normal;
+  float32 w = 1.0f;
+  float32 x = w * std::clamp(a * dot(n, l), -1.0f, 1.0f);
+  for (uint32 i = 0; i < scales; ++i) {
+    const auto s = profile.weight(i);
+    w += s;
+    const auto m = scene.smoothed_normal(i, vid);
+    x += s * std::clamp(a * dot(l, m), -1.0f, 1.0f);
+  }
+  x /= w;
+  x = 0.5f * (1.0f + x);
+  const auto lambert = 0.5f * (1.0f + std::clamp(dot(n, l), -1.0f, 1.0f));
+  return 0.01f * x + 0.99f * lambert;
+}
+
+/// Compute the shading intensities of all vertices in parallel.
+/// The output needs to provide one element per vertex.
+/// So, it may also point to mapped GPU memory.
+///
+inline void shade_vertices(const scene& scene,
+                           vec3 l,
+                           uint32 scales,
+                           const shading_profile& profile,
+                           span<float32> intensities) {
+  DEMO_TRACE_SCOPE("shade_vertices");
+  assert(intensities.size() == scene.vertices.size());
+  parallel_for(scene.vertices.size(), [&](size_t first, size_t last) {
+    for (auto vid = first; vid < last; ++vid)
+      intensities[vid] = exaggerated_intensity(scene, vid, l, scales, profile);
+  });
+}
+
+}  // namespace demo
@@ -0,0 +1,126 @@
+// The viewer prepends the '#version' directive and the following
+// definition to generate a variant of the shader per normal encoding.
+//   NORMAL_ENCODING: storage of smoothed normals
+//     0: float4, 1: octahedral snorm16x2, 2: half4
+//
+// Every dispatch computes one level of smoothed normals like
+// 'scene::smooth_normals'. The previous level is read in full precision
+// and the new level is written in full precision and in encoded form.
+
+layout (local_size_x = 256) in;
+
+uniform uint count = 0;
+// Level that is computed
+uniform uint level = 0;
+// Previous level given by
+//   0: normals of the vertices
+//   1: full-precision level in 'previous_level'
+//   2: encoded level 'level - 1' in 'smoothed_normals'
+uniform uint source = 0;
+
+layout (std430, binding = 0) buffer smoothed_normals {
+  uint words[];
+};
+
+// Vertices consist of a position and a normal.
+layout (std430, binding = 1) readonly buffer vertices {
+  float vertex_data[];
+};
+
+// CSR adjacency of 'scene'
+layout (std430, binding = 3) readonly buffer neighbor_offsets {
+  uint offsets[];
+};
+layout (std430, binding = 4) readonly buffer neighbor_indices {
+  uint neighbors[];
+};
+
+// Levels in full precision as structure of arrays
+layout (std430, binding = 5) readonly buffer previous_level {
+  float previous[];
+};
+layout (std430, binding = 6) writeonly buffer current_level {
+  float current[];
+};
+
+vec3 decode_octahedral(uint word) {
+  vec2 q = unpackSnorm2x16(word);
+  vec3 m = vec3(q, 1.0 - abs(q.x) - abs(q.y));
+  float t = max(-m.z, 0.0);
+  m.xy += mix(vec2(t), vec2(-t), greaterThanEqual(m.xy, vec2(0.0)));
+  return normalize(m);
+}
+
+// Of the four neighboring snorm16 grid points,
+// choose the one with the smallest decoding error like on the CPU.
+uint encode_octahedral(vec3 n) {
+  vec2 p = n.xy / (abs(n.x) + abs(n.y) + abs(n.z));
+  if (n.z < 0.0)
+    p = (1.0 - abs(p.yx)) *
+        mix(vec2(-1.0), vec2(1.0), greaterThanEqual(p, vec2(0.0)));
+  const float scale = 32767.0;
+  uint result = 0u;
+  float best = -2.0;
+  for (int i = 0; i < 4; ++i) {
+    const float x = ((i & 1) != 0) ? ceil(p.x * scale) : floor(p.x * scale);
+    const float y = ((i & 2) != 0) ? ceil(p.y * scale) : floor(p.y * scale);
+    const vec2 q = vec2(x, y);
+    const uint word = packSnorm2x16(q / scale);
+    const float d = dot(decode_octahedral(word), n);
+    if (d <= best) continue;
+    best = d;
+    result = word;
+  }
+  return result;
+}
+
+vec3 load(uint i) {
+  if (source == 0u)
+    return vec3(vertex_data[6u * i + 3u],
+                vertex_data[6u * i + 4u],
+                vertex_data[6u * i + 5u]);
+  if (source == 1u)
+    return vec3(previous[i], previous[count + i], previous[2u * count + i]);
+  const uint k = (level - 1u) * count + i;
+#if NORMAL_ENCODING == 1
+  return decode_octahedral(words[k]);
+#elif NORMAL_ENCODING == 2
+  return vec3(unpackHalf2x16(words[2u * k]),
+              unpackHalf2x16(words[2u * k + 1u]).x);
+#else
+  return uintBitsToFloat(
+      uvec3(words[4u * k], words[4u * k + 1u], words[4u * k + 2u]));
+#endif
+}
+
+void store(uint i, vec3 n) {
+  current[i] = n.x;
+  current[count + i] = n.y;
+  current[2u * count + i] = n.z;
+  const uint k = level * count + i;
+#if NORMAL_ENCODING == 1
+  words[k] = encode_octahedral(n);
+#elif NORMAL_ENCODING == 2
+  words[2u * k] = packHalf2x16(n.xy);
+  words[2u * k + 1u] = packHalf2x16(vec2(n.z, 0.0));
+#else
+  words[4u * k] = floatBitsToUint(n.x);
+  words[4u * k + 1u] = floatBitsToUint(n.y);
+  words[4u * k + 2u] = floatBitsToUint(n.z);
+  words[4u * k + 3u] = floatBitsToUint(0.0);
+#endif
+}
+
+void main() {
+  const uint id = gl_GlobalInvocationID.x;
+  if (id >= count) return;
+
+  // The summation order and the normalization are the same as on the CPU.
+  // 'precise' forbids contractions into fused multiply-adds.
+  precise vec3 x = load(id);
+  for (uint k = offsets[id]; k < offsets[id + 1u]; ++k)
+    x += load(neighbors[k]);
+  precise float s = 1.0 / sqrt(x.x * x.x + x.y * x.y + x.z * x.z);
+  x *= s;
+  store(id, x);
+}
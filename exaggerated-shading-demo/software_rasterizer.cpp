@@ -0,0 +1,294 @@
+#include "software_rasterizer.hpp"
+//
+#include <atomic>
+#include <numeric>
+
+namespace demo {
+
+namespace {
+
+// Pixels are processed in fixed-size groups along rows.
+// The loops over lanes have no dependencies and no branches,
+// such that the compiler is able to vectorize them.
+constexpr uint32 lanes = 8;
+static_assert(software_rasterizer::tile_size % lanes == 0);
+
+/// Edge function E(x, y) = a * x + b * y + c of the directed edge 'p -> q'.
+/// It is positive for points on the right side in window coordinates.
+/// Edges are always set up in the same canonical direction and negated
+/// afterwards. So, the values of an edge shared by two triangles
+/// are exact negatives of each other and no pixel is drawn twice or missed.
+///
+struct edge_function {
+  float32 a, b, c;
+  // Whether pixel centers on the edge belong to the triangle
+  bool top_left;
+
+  edge_function(float32 px, float32 py, float32 qx, float32 qy) noexcept {
+    const auto flip = (qy < py) || ((qy == py) && (qx < px));
+    if (flip) {
+      swap(px, qx);
+      swap(py, qy);
+    }
+    a = -(qy - py);
+    b = qx - px;
+    c = -(a * px + b * py);
+    if (flip) {
+      a = -a;
+      b = -b;
+      c = -c;
+    }
+    // With y pointing down, the interior lies below top edges
+    // and right of left edges.
+    const auto dx = flip ? (px - qx) : (qx - px);
+    const auto dy = flip ? (py - qy) : (qy - py);
+    top_left = (dy < 0) || ((dy == 0) && (dx > 0));
+  }
+
+  auto covers(float32 e) const noexcept -> bool {
+    return (e > 0) || ((e == 0) && top_left);
+  }
+};
+
+/// Range [first, last) of pixels whose centers lie in [min, max].
+///
+auto pixel_range(float32 min, float32 max, uint32 size) noexcept
+    -> pair<uint32, uint32> {
+  const auto s = float32(size);
+  const auto first = std::clamp(std::ceil(min - 0.5f), 0.0f, s);
+  const auto last = std::clamp(std::floor(max - 0.5f) + 1.0f, 0.0f, s);
+  return {uint32(first), uint32(last)};
+}
+
+}  // namespace
+
+software_rasterizer::software_rasterizer(uint32 width, uint32 height)
+    : frame{width, height},
+      tiles_x{(width + tile_size - 1) / tile_size},
+      tiles_y{(height + tile_size - 1) / tile_size} {}
+
+auto software_rasterizer::render(const scene& scene,
+                                 const camera& camera,
+                                 vec3 light,
+                                 uint32 scales,
+                                 const shading_profile& profile)
+    -> statistics {
+  const auto start = chrono::steady_clock::now();
+  statistics result{};
+
+  intensities.resize(scene.vertices.size());
+  shade_vertices(scene, light, scales, profile, intensities);
+  transform(scene, camera.projection_matrix() * camera.view_matrix());
+  result.triangles = bin(scene);
+
+  // Tiles differ a lot in their amount of work.
+  // So, threads fetch them one by one.
+  const auto tiles = tiles_x * tiles_y;
+  atomic<uint32> next{0};
+  atomic<size_t> fragments{0};
+  parallel_for_chunks(std::min(thread_count(), size_t{tiles}), [&](size_t) {
+    size_t count = 0;
+    for (auto tile = next++; tile < tiles; tile = next++)
+      count += rasterize(scene, tile);
+    fragments += count;
+  });
+  result.fragments = fragments;
+
+  result.time = chrono::steady_clock::now() - start;
+  return result;
+}
+
+void software_rasterizer::transform(const scene& scene, const mat4& matrix) {
+  screen_vertices.resize(scene.vertices.size());
+  const auto w = float32(width());
+  const auto h = float32(height());
+  parallel_for(scene.vertices.size(), [&](size_t first, size_t last) {
+    for (auto i = first; i < last; ++i) {
+      const auto p = matrix * vec4(scene.vertices[i].position, 1.0f);
+      if (p.w <= 0.0f) {
+        screen_vertices[i] = {0.0f, 0.0f, -1.0f, 0.0f};
+        continue;
+      }
+      const auto inv_w = 1.0f / p.w;
+      screen_vertices[i] = {
+          .x = 0.5f * (p.x * inv_w + 1.0f) * w,
+          .y = 0.5f * (1.0f - p.y * inv_w) * h,
+          .z = 0.5f * (p.z * inv_w + 1.0f),
+          .inv_w = inv_w,
+      };
+    }
+  });
+}
+
+auto software_rasterizer::bin(const scene& scene) -> size_t {
+  const auto n = scene.faces.size();
+  const auto chunks = chunk_count(n);
+  bins.resize(chunks);
+  vector<size_t> counts(chunks);
+  parallel_for_chunks(chunks, [&](size_t chunk) {
+    auto& tiles = bins[chunk];
+    tiles.resize(tiles_x * tiles_y);
+    for (auto& t : tiles) t.clear();
+
+    size_t count = 0;
+    const auto first = chunk_begin(chunk, n, chunks);
+    const auto last = chunk_begin(chunk + 1, n, chunks);
+    for (auto f = first; f < last; ++f) {
+      const auto& [i, j, k] = scene.faces[f];
+      const auto& a = screen_vertices[i];
+      const auto& b = screen_vertices[j];
+      const auto& c = screen_vertices[k];
+      if ((a.z < 0.0f) || (b.z < 0.0f) || (c.z < 0.0f)) continue;
+      const auto area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      if (area == 0.0f) continue;
+
+      const auto [x0, x1] = pixel_range(std::min({a.x, b.x, c.x}),
+                                        std::max({a.x, b.x, c.x}), width());
+      const auto [y0, y1] = pixel_range(std::min({a.y, b.y, c.y}),
+                                        std::max({a.y, b.y, c.y}), height());
+      if ((x0 >= x1) || (y0 >= y1)) continue;
+
+      for (auto ty = y0 / tile_size; ty <= (y1 - 1) / tile_size; ++ty)
+        for (auto tx = x0 / tile_size; tx <= (x1 - 1) / tile_size; ++tx)
+          tiles[ty * tiles_x + tx].push_back(f);
+      ++count;
+    }
+    counts[chunk] = count;
+  });
+  return std::reduce(counts.begin(), counts.end());
+}
+
+auto software_rasterizer::rasterize(const scene& scene, uint32 tile)
+    -> size_t {
+  const auto px0 = (tile % tiles_x) * tile_size;
+  const auto py0 = (tile / tiles_x) * tile_size;
+  const auto px1 = std::min(px0 + tile_size, width());
+  const auto py1 = std::min(py0 + tile_size, height());
+
+  // Depth is cleared to the far plane and color to the background.
+  array<float32, tile_size * tile_size> depth;
+  array<float32, tile_size * tile_size> color;
+  depth.fill(1.0f);
+  color.fill(background);
+
+  size_t fragments = 0;
+  for (const auto& chunk : bins) {
+    for (const auto f : chunk[tile]) {
+      auto [i, j, k] = scene.faces[f];
+      auto a = screen_vertices[i];
+      auto b = screen_vertices[j];
+      auto c = screen_vertices[k];
+      // Triangles are not culled. So, make their orientation consistent.
+      auto area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      if (area < 0.0f) {
+        swap(b, c);
+        swap(j, k);
+        area = -area;
+      }
+      const auto inv_area = 1.0f / area;
+      const edge_function ea{b.x, b.y, c.x, c.y};
+      const edge_function eb{c.x, c.y, a.x, a.y};
+      const edge_function ec{a.x, a.y, b.x, b.y};
+      const auto ia = intensities[i];
+      const auto ib = intensities[j];
+      const auto ic = intensities[k];
+
+      auto [x0, x1] = pixel_range(std::min({a.x, b.x, c.x}),
+                                  std::max({a.x, b.x, c.x}), width());
+      auto [y0, y1] = pixel_range(std::min({a.y, b.y, c.y}),
+                                  std::max({a.y, b.y, c.y}), height());
+      // Start at a multiple of the lanes. Then, groups never leave the tile.
+      x0 = px0 + (std::max(x0, px0) - px0) / lanes * lanes;
+      x1 = std::min(x1, px1);
+      y0 = std::max(y0, py0);
+      y1 = std::min(y1, py1);
+
+      for (auto y = y0; y < y1; ++y) {
+        const auto fy = float32(y) + 0.5f;
+        const auto ra = ea.b * fy + ea.c;
+        const auto rb = eb.b * fy + eb.c;
+        const auto rc = ec.b * fy + ec.c;
+        const auto row = (y - py0) * tile_size;
+        for (auto x = x0; x < x1; x += lanes) {
+          for (uint32 l = 0; l < lanes; ++l) {
+            const auto fx = float32(x + l) + 0.5f;
+            const auto da = ea.a * fx + ra;
+            const auto db = eb.a * fx + rb;
+            const auto dc = ec.a * fx + rc;
+            // Barycentric coordinates in window space
+            const auto ba = da * inv_area;
+            const auto bb = db * inv_area;
+            const auto bc = dc * inv_area;
+            const auto z = ba * a.z + bb * b.z + bc * c.z;
+            // Perspective-correct interpolation of the intensity
+            const auto qa = ba * a.inv_w;
+            const auto qb = bb * b.inv_w;
+            const auto qc = bc * c.inv_w;
+            const auto intensity =
+                (qa * ia + qb * ib + qc * ic) / (qa + qb + qc);
+            const auto index = row + (x + l - px0);
+            const bool pass = (x + l < x1) & ea.covers(da) & eb.covers(db) &
+                              ec.covers(dc) & (z <= 1.0f) &
+                              (z < depth[index]);
+            depth[index] = pass ? z : depth[index];
+            color[index] = pass ? intensity : color[index];
+            fragments += pass;
+          }
+        }
+      }
+    }
+  }
+
+  // Convert to 8-bit colors like a normalized fixed-point framebuffer.
+  for (auto y = py0; y < py1; ++y) {
+    for (auto x = px0; x < px1; ++x) {
+      const auto c = std::clamp(color[(y - py0) * tile_size + (x - px0)],
+                                0.0f, 1.0f);
+      const auto value = uint8(std::lround(255.0f * c));
+      auto* pixel = frame(x, y);
+      pixel[0] = pixel[1] = pixel[2] = value;
+    }
+  }
+  return fragments;
+}
+
+void render_software_turntable(const scene& scene,
+                               uint32 width,
+                               uint32 height,
+                               uint32 scales,
+                               size_t frames,
+                               const filesystem::path& directory) {
+  // Place the camera like the viewer does after fitting it to the scene.
+  camera camera{};
+  camera.set_screen_resolution(width, height);
+  const auto box = aabb_from(scene);
+  const auto origin = box.origin();
+  const auto bounding_radius = box.radius();
+  const auto radius = bounding_radius / tan(0.5f * camera.vfov());
+  camera.set_near_and_far(
+      std::max(1e-3f * bounding_radius, radius - 10.0f * bounding_radius),
+      radius + 10.0f * bounding_radius);
+  const vec3 up{0, 1, 0};
+  const vec3 right{1, 0, 0};
+  const vec3 front{0, 0, 1};
+
+  filesystem::create_directories(directory);
+  software_rasterizer rasterizer{width, height};
+  software_rasterizer::statistics total{};
+  for (size_t i = 0; i < frames; ++i) {
+    const auto azimuth = 2 * pi * i / frames;
+    const auto d = horizontal_direction(0.0f, azimuth, right, front, up);
+    camera.move(origin + radius * d).look_at(origin, up);
+    const auto l = light_direction(camera.view_matrix(), default_light);
+    const auto stats = rasterizer.render(scene, camera, l, scales);
+    total.triangles += stats.triangles;
+    total.fragments += stats.fragments;
+    total.time += stats.time;
+    save_ppm(rasterizer.result(), directory / format("frame-{:04}.ppm", i));
+  }
+  println("Rasterized {} frames to '{}' in {:.3f} s ({:.3f} M triangles/s).",
+          frames, directory.string(), total.time.count(),
+          1e-6 * total.triangles / total.time.count());
+}
+
+}  // namespace demo
@@ -0,0 +1,83 @@
+#pragma once
+#include "camera.hpp"
+#include "image.hpp"
+#include "scene.hpp"
+#include "shading.hpp"
+
+namespace demo {
+
+/// CPU reference of the OpenGL pipeline given by 'vs.glsl' and 'fs.glsl'.
+/// Vertices are shaded by 'shade_vertices' and their intensities are
+/// interpolated perspective-correctly over depth-tested triangles.
+/// The screen is split into tiles that are rasterized in parallel.
+/// It needs no OpenGL at all and serves as golden-image oracle.
+///
+class software_rasterizer {
+ public:
+  static constexpr uint32 tile_size = 64;
+
+  // Clear color of the viewer
+  static constexpr float32 background = 0.8f;
+
+  struct statistics {
+    // Triangles that have been binned to at least one tile
+    size_t triangles = 0;
+    // Fragments that passed the depth test
+    size_t fragments = 0;
+    chrono::duration<float64> time{};
+  };
+
+  software_rasterizer(uint32 width, uint32 height);
+
+  auto width() const noexcept { return frame.width; }
+  auto height() const noexcept { return frame.height; }
+
+  /// The image of the last rendered frame.
+  ///
+  auto result() const noexcept -> const image& { return frame; }
+
+  /// Render the scene with exaggerated shading for the model-space
+  /// light direction 'light'. Triangles that reach behind the near plane
+  /// are dropped instead of being clipped.
+  ///
+  auto render(const scene& scene,
+              const camera& camera,
+              vec3 light,
+              uint32 scales,
+              const shading_profile& profile = {}) -> statistics;
+
+ private:
+  // Window coordinates with the origin in the upper left corner.
+  // Depth is in [0, 1] and negative for vertices behind the near plane.
+  struct screen_vertex {
+    float32 x, y, z;
+    float32 inv_w;
+  };
+
+  void transform(const scene& scene, const mat4& matrix);
+  auto bin(const scene& scene) -> size_t;
+  auto rasterize(const scene& scene, uint32 tile) -> size_t;
+
+  image frame;
+  uint32 tiles_x;
+  uint32 tiles_y;
+
+  // Buffers are kept to not reallocate them for every frame.
+  vector<screen_vertex> screen_vertices{};
+  vector<float32> intensities{};
+  // Face indices per face chunk and tile.
+  // Processing chunks in order keeps the drawing order of OpenGL.
+  vector<vector<vector<scene::face_index>>> bins{};
+};
+
+/// Render a full rotation of the camera around the scene
+/// like 'viewer::render_turntable' but without any OpenGL context.
+///
+void render_software_turntable(const scene& scene,
+                               uint32 width,
+                               uint32 height,
+                               uint32 scales,
+                               size_t frames,
+                               const filesystem::path& directory);
+
+}  // namespace demo
@@ -0,0 +1,71 @@
+#pragma once
+#include "defaults.hpp"
+
+namespace demo {
+
+/// Summary of measured samples, such as frame times.
+/// Percentiles use the nearest-rank method.
+///
+struct sample_summary {
+  size_t count = 0;
+  float64 mean = 0;
+  float64 min = 0;
+  float64 p50 = 0;
+  float64 p95 = 0;
+  float64 p99 = 0;
+  float64 max = 0;
+};
+
+/// Smallest sample such that at least the fraction 'p'
+/// of all samples are less than or equal to it.
+///
+inline auto percentile(span<const float64> sorted, float64 p) noexcept
+    -> float64 {
+  if (sorted.empty()) return 0;
+  const auto rank = size_t(std::ceil(p * sorted.size()));
+  return sorted[std::clamp(rank, size_t{1}, sorted.size()) - 1];
+}
+
+inline auto summarize(vector<float64> samples) -> sample_summary {
+  if (samples.empty()) return {};
+  std::ranges::sort(samples);
+  float64 sum = 0;
+  for (auto x : samples) sum += x;
+  return {
+      .count = samples.size(),
+      .mean = sum / samples.size(),
+      .min = samples.front(),
+      .p50 = percentile(samples, 0.50),
+      .p95 = percentile(samples, 0.95),
+      .p99 = percentile(samples, 0.99),
+      .max = samples.back(),
+  };
+}
+
+/// JSON object with all members of the summary.
+///
+inline auto json(const sample_summary& s) -> string {
+  return format(
+      "{{\"count\": {}, \"mean\": {:.6f}, \"min\": {:.6f}, \"p50\": {:.6f}, "
+      "\"p95\": {:.6f}, \"p99\": {:.6f}, \"max\": {:.6f}}}",
+      s.count, s.mean, s.min, s.p50, s.p95, s.p99, s.max);
+}
+
+/// JSON string literal with escaped quotes, backslashes, and control
+/// characters.
+///
+inline auto json(string_view str) -> string {
+  string result = "\"";
+  for (const auto c : str) {
+    if ((c == '"') || (c == '\\'))
+      result += {'\\', c};
+    else if (static_cast<unsigned char>(c) < 0x20)
+      result += format("\\u{:04x}", int(c));
+    else
+      result += c;
+  }
+  result += '"';
+  return result;
+}
+
+}  // namespace demo
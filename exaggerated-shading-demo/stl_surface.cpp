@@ -1,8 +1,14 @@
 #include "stl_surface.hpp"
+//
+#include <charconv>
+//
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "tracing.hpp"
 
 namespace demo {
 
-void stl_surface::load_from_binary_file(const filesystem::path& path) {
+void stl_surface::load_from_binary_data(string_view data) {
   // Provide some static assertions that make sure the loading works properly.
   static_assert(offsetof(triangle, normal) == 0);
   static_assert(offsetof(triangle, vertex[0]) == 12);
@@ -10,79 +16,220 @@ void stl_surface::load_from_binary_file(const filesystem::path& path) {
   static_assert(offsetof(triangle, vertex[2]) == 36);
   static_assert(sizeof(triangle) == 48);
   static_assert(alignof(triangle) == 4);
+  // Binary STL files are stored in little-endian byte order.
+  static_assert(endian::native == endian::little);
+
+  constexpr size_t header_size = sizeof(header) + sizeof(size_type);
+  constexpr size_t record_size =
+      sizeof(triangle) + sizeof(attribute_byte_count_type);
 
-  fstream file{path, ios::in | ios::binary};
-  if (!file.is_open())
-    throw runtime_error(
-        format("Failed to open STL file from path '{}'.", path.string()));
+  if (data.size() < header_size)
+    throw parser_error{"Failed to read header of binary STL file."};
 
   // We will ignore the header.
   // It has no specific use to us.
-  file.ignore(sizeof(header));
-
-  // Read number of triangles.
+  // Only read the number of triangles.
   size_type size;
-  file.read((char*)&size, sizeof(size));
+  memcpy(&size, data.data() + sizeof(header), sizeof(size));
+
+  // The declared number of triangles must fit into the file.
+  // Otherwise, the file is truncated or not a binary STL file at all.
+  const auto expected = header_size + size_t{size} * record_size;
+  if (data.size() < expected)
+    throw parser_error(format(
+        "Failed to match triangle count {} with file size of {} bytes "
+        "in binary STL file. Expected at least {} bytes.",
+        size, data.size(), expected));
 
   triangles.resize(size);
 
   // Due to padding and alignment issues concerning 'float32' and 'uint16',
-  // we cannot read everything at once.
-  // Instead, we use a simple loop for every triangle.
-  for (auto& t : triangles) {
-    file.read((char*)&t, sizeof(triangle));
-    // Ignore the attribute byte count.
-    // There should not be any information anyway.
-    file.ignore(sizeof(attribute_byte_count_type));
-  }
+  // records cannot be copied at once.
+  // Still, every record is independent and is copied
+  // without the attribute byte count in parallel chunks.
+  const auto records = data.data() + header_size;
+  parallel_for(
+      size,
+      [&](size_t first, size_t last) {
+        for (auto i = first; i < last; ++i)
+          memcpy(&triangles[i], records + i * record_size, sizeof(triangle));
+      },
+      size_t{1} << 16);
 }
 
-void stl_surface::load_from_ascii_file(const filesystem::path& path) {
-  fstream file{path, ios::in | ios::binary};
-  if (!file.is_open())
-    throw runtime_error(
-        format("Failed to open STL file from path '{}'.", path.string()));
-
-  string name;
-  string line;
-  getline(file, line);
-  stringstream input{line};
-  string keyword;
-  input >> keyword;
-
-  const auto match = [&](czstring str) {
-    file >> keyword;
-    if (keyword == str) return;
+void stl_surface::load_from_binary_file(const filesystem::path& path) {
+  const mapped_file file{path};
+  load_from_binary_data(file.content());
+}
+
+namespace {
+
+constexpr auto is_space(char c) noexcept {
+  return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t') ||
+         (c == '\v') || (c == '\f');
+}
+
+/// Allocation-free tokenizer for ASCII-based STL files.
+/// Tokens are views into the underlying file content.
+///
+struct ascii_parser {
+  using triangle = stl_surface::triangle;
+  using parser_error = stl_surface::parser_error;
+
+  const char* it;
+  const char* end;
+
+  void skip_space() noexcept {
+    while ((it != end) && is_space(*it)) ++it;
+  }
+
+  auto token() noexcept -> string_view {
+    skip_space();
+    const auto first = it;
+    while ((it != end) && !is_space(*it)) ++it;
+    return {first, it};
+  }
+
+  void match(string_view str) {
+    if (token() == str) return;
     throw parser_error(
         format("Failed to match keyword '{}' in ASCII-based STL file.", str));
-  };
+  }
 
-  if (keyword != "solid")
+  void read(float32& x) {
+    skip_space();
+    // 'from_chars' does not accept an explicit plus sign.
+    if ((it != end) && (*it == '+')) ++it;
+    const auto [ptr, error] = from_chars(it, end, x);
+    if (error != errc{})
+      throw parser_error{
+          "Failed to parse floating-point number in ASCII-based STL file."};
+    it = ptr;
+  }
+
+  void read(vec3& v) {
+    read(v.x);
+    read(v.y);
+    read(v.z);
+  }
+
+  /// Parse facets until 'last' or the end of the solid has been reached.
+  /// Returns whether the keyword 'endsolid' has been matched.
+  ///
+  auto parse_facets(const char* last, string_view name, vector<triangle>& out)
+      -> bool {
+    while (true) {
+      skip_space();
+      if (it >= last) return false;
+      const auto keyword = token();
+      if (keyword == "endsolid") {
+        match(name);
+        return true;
+      } else if (keyword == "facet") {
+        triangle t{};
+        match("normal");
+        read(t.normal);
+        match("outer");
+        match("loop");
+        for (int i = 0; i < 3; ++i) {
+          match("vertex");
+          read(t.vertex[i]);
+        }
+        match("endloop");
+        match("endfacet");
+        out.push_back(t);
+      } else
+        throw parser_error{"Failed to match keyword 'facet' or 'endsolid'."};
+    }
+  }
+};
+
+/// Find the start of the first 'facet' keyword at or after 'first'
+/// that is followed by the keyword 'normal'.
+/// Returns the end of the content if there is no such keyword.
+///
+auto next_facet(string_view content, size_t first) noexcept -> size_t {
+  constexpr string_view keyword = "facet";
+  for (auto pos = content.find(keyword, first); pos != string_view::npos;
+       pos = content.find(keyword, pos + 1)) {
+    // Reject matches inside other tokens, like 'endfacet'.
+    if ((pos == 0) || !is_space(content[pos - 1])) continue;
+    ascii_parser parser{content.data() + pos + keyword.size(),
+                        content.data() + content.size()};
+    if ((parser.it != parser.end) && !is_space(*parser.it)) continue;
+    if (parser.token() == "normal") return pos;
+  }
+  return content.size();
+}
+
+}  // namespace
+
+void stl_surface::load_from_ascii_data(string_view content) {
+  // The first line contains the keyword 'solid' and an optional name.
+  const auto line_end = std::min(content.find('\n'), content.size());
+  ascii_parser header{content.data(), content.data() + line_end};
+  if (header.token() != "solid")
     throw parser_error{"Failed to match keyword 'solid' at the start."};
-  input >> name;
-
-  while (file >> keyword) {
-    if (keyword == "endsolid") {
-      match(name.c_str());
-      return;
-    } else if (keyword == "facet") {
-      triangle t{};
-      match("normal");
-      file >> t.normal.x >> t.normal.y >> t.normal.z;
-      match("outer");
-      match("loop");
-      for (int i = 0; i < 3; ++i) {
-        match("vertex");
-        file >> t.vertex[i].x >> t.vertex[i].y >> t.vertex[i].z;
-      }
-      match("endloop");
-      match("endfacet");
-      triangles.push_back(t);
-    } else
-      throw parser_error{"Failed to match keyword 'facet' or 'endsolid'."};
+  const auto name = header.token();
+
+  // Split the remaining content into chunks at facet boundaries.
+  // Every chunk is then parsed independently on its own thread.
+  // Facets may not cross chunk boundaries. So, chunks start
+  // exactly at the tokens the serial parser expects.
+  //
+  constexpr size_t grain = size_t{1} << 20;
+  const auto first = line_end;
+  const auto chunks = std::clamp((content.size() - first) / grain,  //
+                                 size_t{1}, thread_count());
+  vector<size_t> bounds(chunks + 1);
+  bounds[0] = first;
+  bounds[chunks] = content.size();
+  for (size_t i = 1; i < chunks; ++i)
+    bounds[i] = std::max(
+        bounds[i - 1],
+        next_facet(content, first + i * (content.size() - first) / chunks));
+
+  struct chunk_result {
+    vector<triangle> triangles{};
+    bool finished = false;
+    exception_ptr error{};
+  };
+  vector<chunk_result> results(chunks);
+  parallel_for_chunks(chunks, [&](size_t i) {
+    auto& result = results[i];
+    // Give a rough estimate for the required triangles.
+    // A facet usually takes about 250 bytes.
+    result.triangles.reserve((bounds[i + 1] - bounds[i]) / 256);
+    ascii_parser parser{content.data() + bounds[i],
+                        content.data() + content.size()};
+    try {
+      result.finished = parser.parse_facets(content.data() + bounds[i + 1],
+                                            name, result.triangles);
+    } catch (...) {
+      result.error = current_exception();
+    }
+  });
+
+  // Merging the chunks in order reproduces the serial parser:
+  // Errors and the end of the solid in earlier chunks
+  // hide everything that comes after them.
+  //
+  size_t size = triangles.size();
+  for (const auto& result : results) size += result.triangles.size();
+  triangles.reserve(size);
+  for (auto& result : results) {
+    triangles.insert(triangles.end(), result.triangles.begin(),
+                     result.triangles.end());
+    if (result.error) rethrow_exception(result.error);
+    if (result.finished) return;
   }
 }
 
+void stl_surface::load_from_ascii_file(const filesystem::path& path) {
+  const mapped_file file{path};
+  load_from_ascii_data(file.content());
+}
+
 stl_surface::stl_surface(const filesystem::path& path, binary_tag) {
   load_from_binary_file(path);
 }
@@ -91,12 +238,55 @@ stl_surface::stl_surface(const filesystem::path& path, ascii_tag) {
   load_from_ascii_file(path);
 }
 
-stl_surface::stl_surface(const filesystem::path& path) {
-  try {
-    load_from_ascii_file(path);
-  } catch (parser_error&) {
-    load_from_binary_file(path);
+auto stl_surface::is_binary_data(string_view data) noexcept -> bool {
+  constexpr size_t header_size = sizeof(header) + sizeof(size_type);
+  constexpr size_t record_size =
+      sizeof(triangle) + sizeof(attribute_byte_count_type);
+
+  // A file whose size exactly matches the declared number
+  // of triangles is binary, even if its header starts with 'solid'.
+  // Like the binary loader, trailing bytes are allowed as well.
+  bool fits_binary = false;
+  if (data.size() >= header_size) {
+    size_type size;
+    memcpy(&size, data.data() + sizeof(header), sizeof(size));
+    const auto expected = header_size + size_t{size} * record_size;
+    if (data.size() == expected) return true;
+    fits_binary = data.size() > expected;
   }
+
+  // ASCII-based files must start with the keyword 'solid'.
+  constexpr auto blank = " \t\r\n\v\f";
+  const auto first = data.find_first_not_of(blank);
+  if ((first == string_view::npos) || !data.substr(first).starts_with("solid"))
+    return true;
+
+  // Text never contains null characters,
+  // but binary headers are often padded with them.
+  if (data.substr(0, header_size).find('\0') != string_view::npos) return true;
+
+  // The 'solid' line of ASCII-based files is followed by a facet
+  // or the end of the solid. So, a file that would also fit into
+  // the binary format without any of them is binary.
+  if (!fits_binary) return false;
+  const auto line_end = data.find('\n', first);
+  const auto next = (line_end == string_view::npos)
+                        ? string_view::npos
+                        : data.find_first_not_of(blank, line_end);
+  if (next == string_view::npos) return true;
+  const auto rest = data.substr(next);
+  return !rest.starts_with("facet") && !rest.starts_with("endsolid");
+}
+
+stl_surface::stl_surface(const filesystem::path& path) {
+  DEMO_TRACE_SCOPE("stl_surface");
+  // Map the file only once and dispatch on its format.
+  // So, no content is ever parsed twice.
+  const mapped_file file{path};
+  if (is_binary_data(file.content()))
+    load_from_binary_data(file.content());
+  else
+    load_from_ascii_data(file.content());
 }
 
 }  // namespace demo
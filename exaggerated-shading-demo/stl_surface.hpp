@@ -40,6 +40,20 @@ struct stl_surface {
   void load_from_ascii_file(const filesystem::path& path);
   void load_from_binary_file(const filesystem::path& path);
 
+  // Parse the raw content of an STL file that
+  // has already been read or memory-mapped.
+  //
+  void load_from_ascii_data(string_view content);
+  void load_from_binary_data(string_view data);
+
+  // Deduce whether the raw content of an STL file is stored in the binary
+  // format by only looking at its header, its first keywords, and its size.
+  // Parsing is not needed. Every file that is deduced as ASCII-based
+  // is too small for its declared number of binary triangles
+  // or continues with a facet after its 'solid' line.
+  //
+  static auto is_binary_data(string_view data) noexcept -> bool;
+
   vector<triangle> triangles{};
 };
 
@@ -0,0 +1,152 @@
+#pragma once
+#include <mutex>
+//
+#include "defaults.hpp"
+#include "statistics.hpp"
+
+// Scoped timers that record nested spans per thread and export them
+// as Chrome trace JSON, viewable in 'chrome://tracing' or Perfetto.
+// They are only compiled in if 'DEMO_TRACING' is defined, for example by
+// configuring with 'config.exaggerated_shading_demo.tracing=true'.
+// Otherwise, 'DEMO_TRACE_SCOPE' expands to nothing and costs nothing.
+
+namespace demo::tracing {
+
+#ifdef DEMO_TRACING
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+using clock = chrono::steady_clock;
+
+struct event {
+  czstring name;
+  clock::time_point begin;
+  clock::time_point end;
+};
+
+/// Events of a single thread.
+/// Only the owning thread appends to them. The lock is uncontended
+/// unless the trace is written while the thread is running.
+///
+struct thread_events {
+  uint32 id;
+  std::mutex lock{};
+  vector<event> events{};
+};
+
+/// Global registry of the events of all threads.
+/// Buffers of finished threads are kept until the trace is written.
+/// Writing consumes all recorded events. So, the memory is bounded by
+/// the events that are recorded between two writes.
+///
+class recorder {
+ public:
+  static auto instance() -> recorder& {
+    static recorder result{};
+    return result;
+  }
+
+  void record(czstring name, clock::time_point begin, clock::time_point end) {
+    thread_local const auto local = add_thread();
+    std::scoped_lock guard{local->lock};
+    local->events.push_back({name, begin, end});
+  }
+
+  /// Write all events recorded since the last write as complete events
+  /// ('ph' = 'X') and release them together with the buffers of finished
+  /// threads. Spans of the same thread nest by their time ranges.
+  ///
+  void write(const filesystem::path& path) {
+    ofstream file{path};
+    if (!file)
+      throw runtime_error(
+          format("Failed to open trace file '{}' for writing.", path.string()));
+    // Timestamps only need a common origin.
+    const auto us = [](clock::time_point t) {
+      return chrono::duration<float64, micro>(t.time_since_epoch()).count();
+    };
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    auto separator = "\n";
+    std::scoped_lock guard{lock};
+    for (auto& thread : threads) {
+      // Finished threads record no further events. Only the registry
+      // still refers to their buffers, which can then be released.
+      const auto finished = thread.use_count() == 1;
+      // Running threads only wait for the events to be taken over.
+      vector<event> events{};
+      {
+        std::scoped_lock thread_guard{thread->lock};
+        swap(events, thread->events);
+      }
+      for (const auto& e : events) {
+        file << separator
+             << format("{{\"name\": {}, \"ph\": \"X\", \"ts\": {:.3f}, "
+                       "\"dur\": {:.3f}, \"pid\": 1, \"tid\": {}}}",
+                       json(e.name), us(e.begin), us(e.end) - us(e.begin),
+                       thread->id);
+        separator = ",\n";
+      }
+      if (finished) thread.reset();
+    }
+    erase(threads, nullptr);
+    file << "\n]}\n";
+    if (!file)
+      throw runtime_error(
+          format("Failed to write trace file '{}'.", path.string()));
+  }
+
+ private:
+  recorder() = default;
+
+  auto add_thread() -> shared_ptr<thread_events> {
+    std::scoped_lock guard{lock};
+    auto result = make_shared<thread_events>(++thread_ids);
+    threads.push_back(result);
+    return result;
+  }
+
+  std::mutex lock{};
+  vector<shared_ptr<thread_events>> threads{};
+  uint32 thread_ids = 0;
+};
+
+/// Record the lifetime of the object as span with the given name.
+/// The name must outlive the recorder, for example a string literal.
+///
+class scope {
+ public:
+  explicit scope(czstring name) noexcept : name{name}, begin{clock::now()} {}
+  ~scope() { recorder::instance().record(name, begin, clock::now()); }
+
+  scope(const scope&) = delete;
+  scope& operator=(const scope&) = delete;
+
+ private:
+  czstring name;
+  clock::time_point begin;
+};
+
+/// Write the trace of all spans recorded since the last trace.
+/// Without compiled-in tracing, only a note is printed.
+///
+inline void write_trace(const filesystem::path& path) {
+  if constexpr (enabled) {
+    recorder::instance().write(path);
+    println("Wrote trace to '{}'.", path.string());
+  } else {
+    println("Failed to write trace. Tracing has not been compiled in.");
+  }
+}
+
+}  // namespace demo::tracing
+
+#ifdef DEMO_TRACING
+#define DEMO_TRACE_CONCAT_IMPL(A, B) A##B
+#define DEMO_TRACE_CONCAT(A, B) DEMO_TRACE_CONCAT_IMPL(A, B)
+#define DEMO_TRACE_SCOPE(NAME) \
+  const ::demo::tracing::scope DEMO_TRACE_CONCAT(trace_scope_, __LINE__)(NAME)
+#else
+#define DEMO_TRACE_SCOPE(NAME)
+#endif
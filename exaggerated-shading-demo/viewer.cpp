@@ -3,23 +3,34 @@
 #include <glbinding/glbinding.h>
 //
 #include "aabb.hpp"
+#include "shading.hpp"
+#include "statistics.hpp"
+#include "tracing.hpp"
 
 namespace demo {
 
-opengl_window::opengl_window(uint width, uint height)
-    : window(sf::VideoMode({width, height}),
-             "Exaggerated Shading Demo",
-             sf::Style::Default,
-             sf::State::Windowed,
-             sf::ContextSettings{
-                 /*.depthBits = */ 24,
-                 /*.stencilBits = */ 8,
-                 /*.antialiasingLevel = */ 4,
-                 /*.majorVersion = */ 4,
-                 /*.minorVersion = */ 6,
-                 /*.attributeFlags = */
-                 sf::ContextSettings::Core /*| sf::ContextSettings::Debug*/,
-                 /*.sRgbCapable = */ false}) {
+opengl_window::opengl_window(uint width, uint height, bool headless) {
+  // Without a display, all frames are drawn into an offscreen framebuffer.
+  // The window stays closed and does not report any events.
+  if (headless) {
+    context = make_unique<egl_context>();
+    offscreen = make_unique<offscreen_framebuffer>(width, height);
+    return;
+  }
+
+  window.create(sf::VideoMode({width, height}),
+                title,
+                sf::Style::Default,
+                sf::State::Windowed,
+                sf::ContextSettings{
+                    /*.depthBits = */ 24,
+                    /*.stencilBits = */ 8,
+                    /*.antialiasingLevel = */ 4,
+                    /*.majorVersion = */ 4,
+                    /*.minorVersion = */ 6,
+                    /*.attributeFlags = */
+                    sf::ContextSettings::Core /*| sf::ContextSettings::Debug*/,
+                    /*.sRgbCapable = */ false});
   // window.setActive(true);
   window.setVerticalSyncEnabled(true);
   window.setKeyRepeatEnabled(false);
@@ -27,7 +38,19 @@ opengl_window::opengl_window(uint width, uint height)
   glbinding::initialize(sf::Context::getFunction);
 }
 
-viewer::viewer(uint width, uint height) : opengl_window{width, height} {
+auto opengl_window::width() const -> uint {
+  return offscreen ? offscreen->width() : window.getSize().x;
+}
+
+auto opengl_window::height() const -> uint {
+  return offscreen ? offscreen->height() : window.getSize().y;
+}
+
+viewer::viewer(uint width, uint height, bool headless)
+    : opengl_window{width, height, headless} {
+  // Offscreen framebuffers never get resized.
+  if (offscreen) on_resize(width, height);
+
   glEnable(GL_DEPTH_TEST);
   // glEnable(GL_MULTISAMPLE);
   // glEnable(GL_POINT_SMOOTH);
@@ -60,6 +83,9 @@ viewer::viewer(uint width, uint height) : opengl_window{width, height} {
   vertex_array.set_element_buffer(elements.buffer());
 
   normals_buffer.bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+  vertices.buffer().bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+  intensities.buffer().bind_base(GL_SHADER_STORAGE_BUFFER, 2);
+  frame.bind_base(0);
 
   czstring vertex_shader_src = (const char[]){
 #embed "vs.glsl" suffix(, )
@@ -77,24 +103,19 @@ viewer::viewer(uint width, uint height) : opengl_window{width, height} {
 }
 
 void viewer::run() {
+  // Headless viewers cannot receive any events.
+  if (offscreen) return;
   while (not done) {
-    while (const auto event = window.pollEvent()) {
-      if (event->is<sf::Event::Closed>())
-        done = true;
-      else if (const auto* resized = event->getIf<sf::Event::Resized>())
-        on_resize(resized->size.x, resized->size.y);
-      else if (const auto* scrolled =
-                   event->getIf<sf::Event::MouseWheelScrolled>()) {
-        zoom(0.1 * scrolled->delta);
-      } else if (const auto* keyPressed =
-                     event->getIf<sf::Event::KeyPressed>()) {
-        if (keyPressed->scancode == sf::Keyboard::Scancode::Escape) done = true;
-        if (keyPressed->scancode == sf::Keyboard::Scancode::Enter) {
-          scale = (scale + 1) % scales;
-          shader.set("scale", scale);
-        }
-      }
+    // Without pending changes, sleep until the next event arrives.
+    // While a scene is loading, wake up regularly to report its progress.
+    // Ongoing uploads are pending work and must not wait for any event.
+    if (not continuous and not frame_dirty and not uploading()) {
+      const auto timeout = loader ? sf::milliseconds(100) : sf::Time::Zero;
+      if (const auto event = window.waitEvent(timeout)) process(*event);
     }
+    // Waiting for events is idle time and not part of the frame.
+    DEMO_TRACE_SCOPE("frame");
+    while (const auto event = window.pollEvent()) process(*event);
 
     // Get new mouse position and compute movement in space.
     const auto new_mouse_pos = sf::Mouse::getPosition(window);
@@ -112,35 +133,112 @@ void viewer::run() {
       }
     }
 
+    poll_loading();
+    if (uploading()) upload_chunk();
+
     if (view_should_update) update_view();
 
-    render();
-    window.display();
+    if (continuous or frame_dirty) {
+      render();
+      window.display();
+      frame_dirty = false;
+    }
+  }
+}
+
+void viewer::process(const sf::Event& event) {
+  if (event.is<sf::Event::Closed>())
+    done = true;
+  else if (const auto* resized = event.getIf<sf::Event::Resized>())
+    on_resize(resized->size.x, resized->size.y);
+  else if (event.is<sf::Event::FocusGained>())
+    // The window content may have been damaged while it was covered.
+    frame_dirty = true;
+  else if (const auto* scrolled =
+               event.getIf<sf::Event::MouseWheelScrolled>()) {
+    zoom(0.1 * scrolled->delta);
+  } else if (const auto* keyPressed = event.getIf<sf::Event::KeyPressed>()) {
+    if (keyPressed->scancode == sf::Keyboard::Scancode::Escape) done = true;
+    if (keyPressed->scancode == sf::Keyboard::Scancode::Backspace)
+      cancel_loading();
+    // Write the spans recorded since the last trace without leaving
+    // the viewer.
+    if (keyPressed->scancode == sf::Keyboard::Scancode::T) {
+      try {
+        tracing::write_trace(trace_path);
+      } catch (const exception& e) {
+        println("{}", e.what());
+      }
+    }
+    if (keyPressed->scancode == sf::Keyboard::Scancode::Enter) {
+      scale = (scale + 1) % scales;
+      shading_dirty = true;
+      frame_dirty = true;
+    }
+    // Changing the number of scales only smoothes or uploads new levels.
+    if ((keyPressed->scancode == sf::Keyboard::Scancode::Equal) ||
+        (keyPressed->scancode == sf::Keyboard::Scancode::NumpadPlus))
+      set_scales(scales + 1);
+    if ((keyPressed->scancode == sf::Keyboard::Scancode::Hyphen) ||
+        (keyPressed->scancode == sf::Keyboard::Scancode::NumpadMinus))
+      set_scales(scales - 1);
+    // Changing the weights selects another specialized shader variant.
+    if (keyPressed->scancode == sf::Keyboard::Scancode::PageUp) {
+      profile.falloff += 0.25f;
+      shading_dirty = true;
+      frame_dirty = true;
+    }
+    if (keyPressed->scancode == sf::Keyboard::Scancode::PageDown) {
+      profile.falloff = std::max(0.0f, profile.falloff - 0.25f);
+      shading_dirty = true;
+      frame_dirty = true;
+    }
   }
 }
 
+void viewer::set_continuous_rendering(bool value) noexcept {
+  continuous = value;
+}
+
+void viewer::set_trace_path(const filesystem::path& path) {
+  trace_path = path;
+}
+
+void viewer::set_reordering(reordering method) noexcept {
+  order = method;
+}
+
+void viewer::set_gpu_smoothing(bool value) noexcept {
+  gpu_smoothing = value;
+}
+
 void viewer::render() {
+  DEMO_TRACE_SCOPE("render");
+  if (shading_dirty) update_shading();
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   vertex_array.bind();
-  glDrawElements(GL_TRIANGLES, 3 * scene.faces.size(), GL_UNSIGNED_INT, 0);
+  // Only faces that have been uploaded completely are drawn.
+  glDrawElements(GL_TRIANGLES, 3 * uploaded.faces, GL_UNSIGNED_INT, 0);
+  // The current region of CPU intensities must not be overwritten
+  // before the draw call has finished.
+  if (cpu_shading) cpu_intensities.release();
 }
 
 void viewer::on_resize(int width, int height) {
   glViewport(0, 0, width, height);
   camera.set_screen_resolution(width, height);
   view_should_update = true;
+  frame_dirty = true;
 }
 
 void viewer::update_view() {
+  DEMO_TRACE_SCOPE("update_view");
   // Compute camera position by using spherical coordinates.
   // This transformation is a variation of the standard
   // called horizontal coordinates often used in astronomy.
   //
-  auto p = cos(altitude) * sin(azimuth) * right +  //
-           cos(altitude) * cos(azimuth) * front +  //
-           sin(altitude) * up;
-  p *= radius;
-  p += origin;
+  const auto d = horizontal_direction(altitude, azimuth, right, front, up);
+  const auto p = origin + radius * d;
   camera.move(p).look_at(origin, up);
 
   // camera.set_near_and_far(std::max(1e-3f * radius, radius - bounding_radius),
@@ -150,30 +248,193 @@ void viewer::update_view() {
       std::max(1e-3f * bounding_radius, radius - 10.0f * bounding_radius),
       radius + 10.0f * bounding_radius);
 
-  shader.set("projection", camera.projection_matrix());
-  shader.set("view", camera.view_matrix());
+  // Only rotations change the light direction in model space.
+  // So, shading does not need to be recomputed for zooming or shifting.
+  const auto l = light_direction(camera.view_matrix(), light);
+  if (l != shading_light) {
+    shading_light = l;
+    shading_dirty = true;
+  }
+
+  frame.write({
+      .projection = camera.projection_matrix(),
+      .view = camera.view_matrix(),
+      .light = vec4{shading_light, 0.0f},
+  });
 
   view_should_update = false;
+  frame_dirty = true;
+}
+
+void viewer::update_shading() {
+  if (not shading_uploaded()) return;
+  DEMO_TRACE_SCOPE("update_shading");
+  shading_dirty = false;
+  if (scene.vertices.empty()) return;
+
+  // The vertex array reads intensities from the second buffer binding.
+  constexpr GLuint intensity_binding = 1;
+
+  const auto shading = shading_variant();
+  cpu_shading = not shading;
+  if (cpu_shading) {
+    // Without compute shaders, levels have not been smoothed on the GPU.
+    if (scene.smoothed_scales() != scales)
+      scene.resize_smoothed_normals(scales);
+    if (cpu_intensities.size() != scene.vertices.size())
+      cpu_intensities =
+          opengl::ring_buffer<float32>{(GLsizeiptr)scene.vertices.size()};
+    shade_vertices(scene, shading_light, scales, profile,
+                   cpu_intensities.acquire());
+    vertex_array.set_vertex_buffer(intensity_binding,
+                                   cpu_intensities.buffer(),
+                                   cpu_intensities.offset(), sizeof(float32));
+    return;
+  }
+
+  vertex_array.set_vertex_buffer(intensity_binding, intensities.buffer(), 0,
+                                 sizeof(float32));
+  shading->try_set("count", (uint32)scene.vertices.size());
+  shading->use();
+  constexpr uint32 group_size = 256;
+  glDispatchCompute((scene.vertices.size() + group_size - 1) / group_size, 1,
+                    1);
+  // Intensities are read as vertex attributes by the following draw call.
+  glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+  shader.use();
+}
+
+auto viewer::shading_variant() -> opengl::program* {
+  // The number of scales, the weights, and the normal encoding
+  // are compiled into the shader to allow for full loop unrolling.
+  const auto preamble = shading_variant_preamble(encoding, scales, profile);
+  auto [it, inserted] = shading_variants.try_emplace(preamble);
+  auto& [variant, last_use] = it->second;
+  last_use = ++shading_variant_uses;
+  if (inserted) {
+    // The new variant is the most recently used one and never evicted.
+    if (shading_variants.size() > max_shading_variants)
+      shading_variants.erase(std::ranges::min_element(
+          shading_variants, {},
+          [](const auto& entry) { return entry.second.last_use; }));
+    czstring source = (const char[]){
+#embed "shade.glsl" suffix(, )
+        0,
+    };
+    const auto status =
+        variant.build(opengl::cs(string_view{preamble}, source));
+    status.print();
+    if (not status.success)
+      println("Falling back to exaggerated shading on the CPU.");
+  }
+  return variant.linked() ? &variant : nullptr;
 }
 
 void viewer::load_scene(const filesystem::path& path) {
-  scene = scene_from(path);
-  scene.generate_edges();
-  scene.smooth_normals(scales);
+  cancel_loading();
+  // Loaders skip the smoothing if it is done on the GPU.
+  loader = make_unique<scene_loader>(path, gpu_smoothing ? 0 : scales,
+                                     encoding, order);
+  show_loading_stage();
+}
 
+void viewer::cancel_loading() {
+  if (!loader) return;
+  loader->cancel();
+  println("Cancelled loading of '{}'.", loader->path().string());
+  retired_loaders.push_back(std::move(loader));
+  window.setTitle(title);
+}
+
+void viewer::show_loading_stage() {
+  shown_stage = loader->current_stage();
+  window.setTitle(format("{} - Loading '{}' ({:.0f}%, {})", title,
+                         loader->path().filename().string(),
+                         100 * progress(shown_stage),
+                         stage_string(shown_stage)));
+}
+
+void viewer::poll_loading() {
+  erase_if(retired_loaders, [](const auto& x) { return x->done(); });
+
+  if (!loader) return;
+  if (loader->current_stage() != shown_stage) show_loading_stage();
+  if (!loader->done()) return;
+
+  try {
+    DEMO_TRACE_SCOPE("finish scene");
+    scene = loader->take();
+    scene_path = loader->path();
+    println("Loaded scene '{}' in {:.3f} s.", loader->path().string(),
+            loader->elapsed().count());
+    upload_scene();
+  } catch (const exception& e) {
+    println("Failed to load scene. {}", e.what());
+  }
+  loader.reset();
+  window.setTitle(title);
+}
+
+void viewer::upload_scene() {
+  DEMO_TRACE_SCOPE("upload_scene");
   fit_view_to_surface();
+  frame_dirty = true;
 
-  // vertex_buffer.assign(scene.vertices);
-  // element_buffer.assign(scene.faces);
-  normals_buffer.assign(scene.smoothed_normals);
+  // Every scene gets new buffers with immutable storage of its final size.
+  // Their content is streamed in chunks by 'upload_chunk' over the next
+  // frames. So, large scenes neither freeze the viewer nor need a second
+  // copy of all their data at once.
+  //
+  const auto allocate = [](opengl::buffer_view buffer, size_t bytes) {
+    // Immutable storage must not be empty.
+    buffer.allocate_storage(std::max(bytes, size_t{1}));
+  };
+  // Scenes without smoothed normals are smoothed on the GPU.
+  // If the compute shader is not available, it is done on the CPU.
+  smoothed_on_gpu =
+      (scene.smoothed_scales() != scales) && (smoothing_program() != nullptr);
+  if (not smoothed_on_gpu && (scene.smoothed_scales() != scales)) {
+    const auto stats = scene.smooth_normals(scales, encoding);
+    println("Smoothed {} scales of normals on the CPU in {:.3f} s.", scales,
+            stats.time.count());
+  }
 
-  vertices.assign(scene.vertices);
-  assert(vertices.size() == scene.vertices.size());
-  elements.assign(scene.faces);
-  assert(elements.size() == scene.faces.size());
+  normals_buffer = opengl::buffer{};
+  allocate(normals_buffer, scales * scene.vertices.size() *
+                               words_per_normal(encoding) * sizeof(uint32));
+  normal_capacity = scales;
+  vertices = opengl::vector<scene::vertex>{};
+  allocate(vertices.buffer(), scene.vertices.size() * sizeof(scene::vertex));
+  elements = opengl::vector<scene::face>{};
+  allocate(elements.buffer(), scene.faces.size() * sizeof(scene::face));
+  intensities = opengl::vector<float32>{};
+  allocate(intensities.buffer(), scene.vertices.size() * sizeof(float32));
+
+  normals_buffer.bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+  vertices.buffer().bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+  intensities.buffer().bind_base(GL_SHADER_STORAGE_BUFFER, 2);
+
+  // Only the adjacency is uploaded for smoothing on the GPU.
+  // The last smoothed level alternates between two full-precision buffers.
+  if (smoothed_on_gpu) {
+    neighbor_offsets = opengl::vector<scene::vertex_index>{};
+    allocate(neighbor_offsets.buffer(),
+             scene.neighbor_offsets.size() * sizeof(scene::vertex_index));
+    neighbors = opengl::vector<scene::vertex_index>{};
+    allocate(neighbors.buffer(),
+             scene.neighbors.size() * sizeof(scene::vertex_index));
+    for (auto& level : smoothing_levels) {
+      level = opengl::buffer{};
+      allocate(level, 3 * scene.vertices.size() * sizeof(float32));
+    }
+    neighbor_offsets.buffer().bind_base(GL_SHADER_STORAGE_BUFFER, 3);
+    neighbors.buffer().bind_base(GL_SHADER_STORAGE_BUFFER, 4);
+    latest_level_buffer = 0;
+    gpu_smoothed_scales = 0;
+  }
 
-  shader.set("scales", (uint32)scales);
-  shader.set("count", (uint32)scene.vertices.size());
+  uploaded = {};
+  upload_start = chrono::steady_clock::now();
 
   // vertex_array.format(
   //     opengl::format<scene::vertex>(vertex_buffer, MEMBER(0, position),
@@ -184,12 +445,304 @@ void viewer::load_scene(const filesystem::path& path) {
   //         .stride = sizeof(vec4),
   //         .attributes = {opengl::attr<vec4>(2, 0)}});
 
+  // Smoothed normals are no vertex attributes.
+  // The vertex shader reads and decodes them from the storage buffer.
   vertex_array.format(
       opengl::format<scene::vertex>(vertices.buffer(),  //
                                     MEMBER(0, position), MEMBER(1, normal)),
-      opengl::offset_format<vec4>(
-          normals_buffer, (scales - 1) * sizeof(vec4) * scene.vertices.size(),
-          ACCESS(2, x, x)));
+      opengl::format<float32>(intensities.buffer(), ACCESS(2, x, x)));
+  vertex_array.set_element_buffer(elements.buffer());
+}
+
+bool viewer::uploading() const noexcept {
+  // Scenes without faces still need their vertices and normals.
+  return not shading_uploaded() || (uploaded.faces < scene.faces.size());
+}
+
+bool viewer::shading_uploaded() const noexcept {
+  if (uploaded.vertices != scene.vertices.size()) return false;
+  if (not smoothed_on_gpu)
+    return uploaded.normals == scene.smoothed_normals.size();
+  return (uploaded.neighbor_offsets == scene.neighbor_offsets.size()) &&
+         (uploaded.neighbors == scene.neighbors.size());
+}
+
+void viewer::upload_chunk() {
+  DEMO_TRACE_SCOPE("upload_chunk");
+  // Shading any face needs all vertices and smoothed normals.
+  // So, they are uploaded first and faces follow in index order.
+  // Smoothing on the GPU needs the adjacency instead of the normals.
+  // Every frame uploads at most 'upload_budget' bytes in total.
+  //
+  auto budget = upload_budget;
+  const auto stream = [&budget](opengl::buffer_view buffer, const auto& data,
+                                size_t& done) {
+    using value_type = ranges::range_value_t<decltype(data)>;
+    if (budget == 0) return;
+    const auto count = std::min(
+        data.size() - done,
+        std::max(budget / sizeof(value_type), size_t{1}));
+    if (count == 0) return;
+    buffer.write(data.data() + done, count, done * sizeof(value_type));
+    done += count;
+    budget -= std::min(budget, count * sizeof(value_type));
+  };
+
+  const auto was_shading_uploaded = shading_uploaded();
+  stream(vertices.buffer(), scene.vertices, uploaded.vertices);
+  if (smoothed_on_gpu) {
+    stream(neighbor_offsets.buffer(), scene.neighbor_offsets,
+           uploaded.neighbor_offsets);
+    stream(neighbors.buffer(), scene.neighbors, uploaded.neighbors);
+  } else
+    stream(normals_buffer, scene.smoothed_normals, uploaded.normals);
+  if (not shading_uploaded()) return;
+  if (not was_shading_uploaded) {
+    if (smoothed_on_gpu) smooth_on_gpu(0, scales);
+    shading_dirty = true;
+  }
+
+  stream(elements.buffer(), scene.faces, uploaded.faces);
+  frame_dirty = true;
+
+  if (uploading()) return;
+  println("Uploaded scene in {:.3f} s.",
+          chrono::duration<float64>(chrono::steady_clock::now() -
+                                    upload_start)
+              .count());
+}
+
+void viewer::set_scales(size_t count) {
+  count = std::clamp(count, size_t{1}, max_scales);
+  if (count == scales) return;
+  // Loaders and uploads refer to the number of scales they started with.
+  if (loader || uploading()) {
+    println("Failed to change scales while a scene is loading.");
+    return;
+  }
+  const auto previous = scales;
+  scales = count;
+  scale = std::min(scale, uint32(scales - 1));
+  shading_dirty = true;
+  frame_dirty = true;
+  if (scene.vertices.empty()) return;
+
+  if (not smoothed_on_gpu) {
+    const auto stats = scene.resize_smoothed_normals(scales);
+    if (scales > previous)
+      println("Smoothed {} additional scales in {:.3f} s.", scales - previous,
+              stats.time.count());
+  }
+  upload_scales(previous);
+}
+
+auto viewer::smoothing_program() -> opengl::program* {
+  // The program is built on first use. A failed build
+  // is kept as well such that it is not retried.
+  if (not smoothing) {
+    const auto preamble = format(
+        "#version 460 core\n"
+        "#define NORMAL_ENCODING {}\n",
+        static_cast<uint32>(encoding));
+    czstring source = (const char[]){
+#embed "smooth.glsl" suffix(, )
+        0,
+    };
+    const auto status =
+        smoothing.emplace().build(opengl::cs(string_view{preamble}, source));
+    status.print();
+    if (not status.success)
+      println("Falling back to smoothing normals on the CPU.");
+  }
+  return smoothing->linked() ? &*smoothing : nullptr;
+}
+
+void viewer::smooth_on_gpu(size_t first, size_t last) {
+  DEMO_TRACE_SCOPE("smooth_on_gpu");
+  const auto n = scene.vertices.size();
+  if (n == 0) return;
+  auto& program = *smoothing_program();
+  program.try_set("count", uint32(n));
+  program.use();
+  constexpr uint32 group_size = 256;
+  for (auto level = first; level < last; ++level) {
+    // Continue from the full-precision level if it is the previous one.
+    // After removing levels, it is decoded like on the CPU instead.
+    const uint32 source = (level == 0)                     ? 0
+                          : (level == gpu_smoothed_scales) ? 1
+                                                           : 2;
+    program.try_set("level", uint32(level));
+    program.try_set("source", source);
+    smoothing_levels[latest_level_buffer].bind_base(GL_SHADER_STORAGE_BUFFER,
+                                                    5);
+    smoothing_levels[1 - latest_level_buffer].bind_base(
+        GL_SHADER_STORAGE_BUFFER, 6);
+    glDispatchCompute((n + group_size - 1) / group_size, 1, 1);
+    // The next level, the shading, and buffer copies read the result.
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT |
+                    GL_BUFFER_UPDATE_BARRIER_BIT);
+    latest_level_buffer = 1 - latest_level_buffer;
+    gpu_smoothed_scales = level + 1;
+  }
+  shader.use();
+}
+
+void viewer::upload_scales(size_t previous) {
+  // Levels are stored one after another. So, new levels are appended
+  // behind the existing ones and removed levels are simply not read.
+  const auto level_words = scene.vertices.size() *
+                           words_per_normal(scene.smoothed_normal_encoding);
+  const auto bytes = [&](size_t levels) {
+    return levels * level_words * sizeof(uint32);
+  };
+
+  // Immutable storage cannot grow. So, a larger buffer reserves
+  // additional levels and existing ones are copied on the GPU.
+  if (scales > normal_capacity) {
+    const auto capacity = std::min(2 * scales, max_scales);
+    opengl::buffer grown{};
+    grown.allocate_storage(bytes(capacity));
+    grown.copy(normals_buffer, 0, 0, bytes(previous));
+    normals_buffer = std::move(grown);
+    normals_buffer.bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+    normal_capacity = capacity;
+  }
+
+  if (smoothed_on_gpu) {
+    if (scales > previous) smooth_on_gpu(previous, scales);
+    return;
+  }
+
+  if (scales > previous)
+    normals_buffer.write(scene.smoothed_normals.data() + previous * level_words,
+                         (scales - previous) * level_words, bytes(previous));
+  uploaded.normals = scene.smoothed_normals.size();
+}
+
+void viewer::render_turntable(const filesystem::path& directory,
+                              size_t frames) {
+  finish_loading();
+  filesystem::create_directories(directory);
+  const auto start = azimuth;
+  for (size_t i = 0; i < frames; ++i) {
+    azimuth = start + 2 * pi * i / frames;
+    update_view();
+    render();
+    save_ppm(read_pixels(width(), height()),
+             directory / format("frame-{:04}.ppm", i));
+    if (not offscreen) window.display();
+  }
+  azimuth = start;
+  view_should_update = true;
+  println("Rendered {} frames to '{}'.", frames, directory.string());
+}
+
+void viewer::finish_loading() {
+  // The scene is completely loaded and uploaded before the first frame.
+  if (loader) {
+    loader->wait();
+    poll_loading();
+  }
+  while (uploading()) upload_chunk();
+}
+
+auto viewer::benchmark(size_t frames) -> string {
+  finish_loading();
+  // Frames must not be throttled by the display.
+  if (not offscreen) window.setVerticalSyncEnabled(false);
+
+  // The camera follows a fixed path that only depends on the frame index.
+  // It turns around the scene, swings up and down, and zooms in and out.
+  // Every frame rotates the view and therefore recomputes the shading.
+  const auto start_altitude = altitude;
+  const auto start_azimuth = azimuth;
+  const auto start_radius = radius;
+  vector<opengl::query> queries{};
+  queries.reserve(frames);
+  vector<float64> cpu_times{};
+  cpu_times.reserve(frames);
+  for (size_t i = 0; i < frames; ++i) {
+    const auto t = float32(i) / frames;
+    azimuth = start_azimuth + 2 * pi * t;
+    altitude = 0.25f * pi * sin(2 * pi * t);
+    radius = start_radius * (1.0f + 0.25f * sin(4 * pi * t));
+
+    const auto frame_start = chrono::steady_clock::now();
+    update_view();
+    const auto& query = queries.emplace_back(GL_TIME_ELAPSED);
+    query.begin(GL_TIME_ELAPSED);
+    render();
+    opengl::query::end(GL_TIME_ELAPSED);
+    if (not offscreen) window.display();
+    // Wait for the GPU such that frames do not overlap.
+    glFinish();
+    cpu_times.push_back(chrono::duration<float64, milli>(
+                            chrono::steady_clock::now() - frame_start)
+                            .count());
+  }
+
+  vector<float64> gpu_times{};
+  gpu_times.reserve(frames);
+  for (const auto& query : queries) gpu_times.push_back(1e-6 * query.result());
+
+  altitude = start_altitude;
+  azimuth = start_azimuth;
+  radius = start_radius;
+  view_should_update = true;
+  if (not offscreen) window.setVerticalSyncEnabled(true);
+
+  const auto cpu = summarize(std::move(cpu_times));
+  const auto gpu = summarize(std::move(gpu_times));
+  const auto triangles = scene.faces.size();
+  return format(
+      "{{\n"
+      "  \"scene\": {},\n"
+      "  \"width\": {},\n"
+      "  \"height\": {},\n"
+      "  \"frames\": {},\n"
+      "  \"vertices\": {},\n"
+      "  \"triangles\": {},\n"
+      "  \"scales\": {},\n"
+      "  \"reordering\": {},\n"
+      "  \"smoothing\": {},\n"
+      "  \"shading\": {},\n"
+      "  \"cpu_frame_time_ms\": {},\n"
+      "  \"gpu_time_ms\": {},\n"
+      "  \"triangles_per_second\": {:.0f}\n"
+      "}}",
+      json(scene_path.string()), width(), height(), frames,
+      scene.vertices.size(), triangles, scales,
+      json(reordering_string(order)), json(smoothed_on_gpu ? "gpu" : "cpu"),
+      json(cpu_shading ? "cpu" : "gpu"), json(cpu), json(gpu),
+      (cpu.mean > 0) ? 1e3 * triangles / cpu.mean : 0.0);
+}
+
+auto viewer::smoothing_error() -> float32 {
+  finish_loading();
+  if (scene.vertices.empty()) return 0;
+  if (not smoothed_on_gpu)
+    throw runtime_error(
+        "Failed to check smoothing. Normals have not been smoothed on GPU.");
+
+  // The reference only needs the vertices and the adjacency.
+  struct scene reference{};
+  reference.vertices = scene.vertices;
+  reference.neighbor_offsets = scene.neighbor_offsets;
+  reference.neighbors = scene.neighbors;
+  reference.smooth_normals(scales, encoding);
+
+  vector<uint32> words(reference.smoothed_normals.size());
+  normals_buffer.read(words.data(), words.size());
+  const auto n = scene.vertices.size();
+  const auto w = words_per_normal(encoding);
+  float32 result = 0;
+  for (size_t i = 0; i < scales * n; ++i) {
+    const auto x = decode(encoding, &words[i * w]);
+    const auto y = reference.smoothed_normal(i / n, i % n);
+    // Small angles are badly conditioned for 'acos'.
+    result = std::max(result, std::atan2(length(cross(x, y)), dot(x, y)));
+  }
+  return result;
 }
 
 void viewer::fit_view_to_surface() {
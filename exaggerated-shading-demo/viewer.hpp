@@ -3,13 +3,24 @@
 //
 #include "camera.hpp"
 #include "defaults.hpp"
+#include "offscreen.hpp"
 #include "scene.hpp"
+#include "scene_loader.hpp"
+#include "shading.hpp"
 
 namespace demo {
 
 struct opengl_window {
+  static constexpr czstring title = "Exaggerated Shading Demo";
   sf::Window window{};
-  opengl_window(uint width, uint height);
+  // Headless windows have no display and render offscreen instead.
+  // The framebuffer needs to be destroyed before its context.
+  unique_ptr<egl_context> context{};
+  unique_ptr<offscreen_framebuffer> offscreen{};
+  opengl_window(uint width, uint height, bool headless = false);
+
+  auto width() const -> uint;
+  auto height() const -> uint;
 };
 
 class viewer : public opengl_window {
@@ -33,35 +44,153 @@ class viewer : public opengl_window {
   float bounding_radius = 1.0f;
   bool view_should_update = true;
 
+  // Frames are only rendered if something has changed since the last one.
+  // Continuous rendering redraws every frame and is meant for benchmarks.
+  bool frame_dirty = true;
+  bool continuous = false;
+
   struct scene scene{};
+  filesystem::path scene_path{};
   size_t scales = 10;
+  static constexpr size_t max_scales = 32;
   uint32 scale = 0;
+  normal_encoding encoding = normal_encoding::octahedral;
+  reordering order = reordering::tipsify;
+
+  // Scenes are loaded in the background while the previous one is drawn.
+  // Cancelled loaders are kept until their worker thread has stopped.
+  unique_ptr<scene_loader> loader{};
+  vector<unique_ptr<scene_loader>> retired_loaders{};
+  scene_loader::stage shown_stage{};
 
   opengl::vertex_array vertex_array{};
   // opengl::buffer vertex_buffer{};
   // opengl::buffer element_buffer{};
   opengl::buffer normals_buffer{};
+  // Levels of smoothed normals that fit into 'normals_buffer'.
+  // Additional levels are appended in place as long as they fit.
+  size_t normal_capacity = 0;
   opengl::program shader{};
 
+  // Camera and light state shared by all shaders as uniform block.
+  // Its layout matches the 'std140' block 'frame' in the shaders.
+  struct frame_uniforms {
+    mat4 projection;
+    mat4 view;
+    vec4 light;
+  };
+  opengl::uniform_buffer<frame_uniforms> frame{};
+
   opengl::vector<scene::vertex> vertices{};
   opengl::vector<scene::face> elements{};
 
+  // Scenes are uploaded progressively in chunks spread across frames.
+  // These are the numbers of elements already uploaded per buffer.
+  static constexpr size_t upload_budget = size_t{32} << 20;
+  struct upload_progress {
+    size_t vertices = 0;
+    size_t normals = 0;
+    size_t neighbor_offsets = 0;
+    size_t neighbors = 0;
+    size_t faces = 0;
+  } uploaded{};
+  chrono::steady_clock::time_point upload_start{};
+
+  // Smoothing on the GPU uploads the CSR adjacency instead of all levels
+  // of smoothed normals. Levels are computed by 'smooth.glsl' directly
+  // into 'normals_buffer'. The last computed level is kept in full
+  // precision in one of two alternating buffers to continue from it.
+  bool gpu_smoothing = false;
+  bool smoothed_on_gpu = false;
+  optional<opengl::program> smoothing{};
+  opengl::vector<scene::vertex_index> neighbor_offsets{};
+  opengl::vector<scene::vertex_index> neighbors{};
+  array<opengl::buffer, 2> smoothing_levels{};
+  uint32 latest_level_buffer = 0;
+  size_t gpu_smoothed_scales = 0;
+
+  // Exaggerated shading is cached as one intensity per vertex.
+  // It is only recomputed when the light direction in model space
+  // or the scale parameters change. Without compute shaders,
+  // intensities are computed on the CPU directly into a persistently
+  // mapped ring buffer and read from its current region.
+  vec4 light = default_light;
+  vec3 shading_light{};
+  bool shading_dirty = true;
+  shading_profile profile{};
+  // Specialized variants of the shading compute shader by their preamble.
+  // Failed builds are kept as well so that they are not retried.
+  // Every change of the profile specializes another variant.
+  // So, only the most recently used variants are kept.
+  struct shading_variant_entry {
+    opengl::program program{};
+    uint64_t last_use = 0;
+  };
+  static constexpr size_t max_shading_variants = 8;
+  map<string, shading_variant_entry> shading_variants{};
+  uint64_t shading_variant_uses = 0;
+  opengl::vector<float32> intensities{};
+  opengl::ring_buffer<float32> cpu_intensities{};
+  bool cpu_shading = false;
+
+  // Target of the trace that is written on demand.
+  filesystem::path trace_path = "trace.json";
+
  public:
-  viewer(uint width = 500, uint height = 500);
+  viewer(uint width = 500, uint height = 500, bool headless = false);
 
   void run();
 
+  void set_continuous_rendering(bool value) noexcept;
+  void set_trace_path(const filesystem::path& path);
+  // Applies to scenes that are loaded afterwards.
+  void set_reordering(reordering method) noexcept;
+  // Applies to scenes that are loaded afterwards.
+  void set_gpu_smoothing(bool value) noexcept;
+
   void load_scene(const filesystem::path& path);
+  void cancel_loading();
   void fit_view_to_surface();
 
+  /// Render a full rotation of the camera around the scene
+  /// and store every frame as image in the given directory.
+  ///
+  void render_turntable(const filesystem::path& directory, size_t frames);
+
+  /// Render the given number of frames along a deterministic camera path
+  /// and measure CPU frame times and GPU times of all draw and shading
+  /// commands. Returns percentiles and throughput as JSON report.
+  ///
+  auto benchmark(size_t frames) -> string;
+
+  /// Largest angle in radians between the smoothed normals on the GPU
+  /// and the ones computed by 'scene::smooth_normals' on the CPU.
+  /// Throws if the normals of the scene have not been smoothed on the GPU.
+  ///
+  auto smoothing_error() -> float32;
+
   void turn(const vec2& angle);
   void shift(const vec2& pixels);
   void zoom(float scale);
 
  protected:
   void render();
+  void process(const sf::Event& event);
   void on_resize(int width, int height);
   void update_view();
+  void update_shading();
+  auto shading_variant() -> opengl::program*;
+  void poll_loading();
+  void finish_loading();
+  void show_loading_stage();
+  void upload_scene();
+  void upload_chunk();
+  void set_scales(size_t count);
+  auto smoothing_program() -> opengl::program*;
+  void smooth_on_gpu(size_t first, size_t last);
+  void upload_scales(size_t previous);
+  bool uploading() const noexcept;
+  bool shading_uploaded() const noexcept;
 };
 
 }  // namespace demo